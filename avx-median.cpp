@@ -1,168 +1,2245 @@
-﻿#include "avx-median.h"
-#include <celero/Celero.h>
-#include <random>
-#include <cassert>
-#include <iostream>
-#include <iomanip>
-
-static constexpr size_t data_size = 131069; // ~512 KB - fits in L2 cache; TODO would be nice to ensure there are no overreads
-static constexpr size_t canary_size = 8;
-static constexpr size_t output_data_size = data_size + 2 * canary_size;
-
-float* input_data;
-float* output_data;
-float* raw_output_data;
-float* golden_output_data;
-
-void dump_reg(const char* const name, rf512 value)
-{
-	union
-	{
-		float f[16];
-		r512f r;
-	} values;
-	store_to_address(values.f, value);
-	std::cout << std::setw(10) << name << " = ";
-	for (int i = 0; i < 15; ++i)
-	{
-		std::cout << std::setw(10) << values.f[i] << " | ";
-	}
-	std::cout << values.f[15] << "\n";
-}
-
-void dump_reg(const char* const name, ri512 value)
-{
-	union
-	{
-		int32_t f[16];
-		ri512 r;
-	} values;
-	store_to_address(values.f, value);
-	std::cout << std::setw(10) << name << " = ";
-	for (int i = 0; i < 15; ++i)
-	{
-		std::cout << std::setw(10) << values.f[i] << " | ";
-	}
-	std::cout << values.f[15] << "\n";
-}
-
-static void validate(void(*method)(const float*, float*, size_t))
-{
-	std::fill_n((uint8_t*)raw_output_data, output_data_size * sizeof(raw_output_data[0]), 0xCD);
-	method(input_data, output_data, data_size);
-	if (!std::equal(raw_output_data, raw_output_data + output_data_size, golden_output_data))
-	{
-		assert(false);
-		std::cerr << "Validation failed\n";
-		for (int i = 0; i < canary_size; ++i)
-			std::cerr << "#" << i << ": " << raw_output_data[i] << "\t" << golden_output_data[i] << "\n";
-		for (int i = canary_size; i < canary_size + 32; ++i)
-			std::cerr << "#" << i << ": " << raw_output_data[i] << "\t" << golden_output_data[i] << "\t" << input_data[i - canary_size] << "\n";
-		for (int i = output_data_size - 16; i < output_data_size; ++i)
-			std::cerr << "#" << i << ": " << raw_output_data[i] << "\t" << golden_output_data[i] << "\n";
-		exit(1);
-	}
-}
-
-static void init()
-{
-	std::mt19937 RandomDevice;
-	std::uniform_real_distribution<float> Distribution{ -1, 1 };
-	auto alloc = [](size_t size) -> float* {return reinterpret_cast<float*>(::operator new[](size * sizeof(float), std::align_val_t{ 16 })); };
-	input_data = alloc(data_size);
-	raw_output_data = alloc(output_data_size);
-	golden_output_data = alloc(output_data_size);
-
-	std::generate_n(input_data, data_size, [&]() {return Distribution(RandomDevice); });
-
-	std::fill_n((uint8_t*)raw_output_data, output_data_size * sizeof(raw_output_data[0]), 0xCD);
-	output_data = raw_output_data + canary_size;
-	median_Cpp(input_data, output_data, data_size);
-	std::copy_n(raw_output_data, output_data_size, golden_output_data);
-}
-
-static void validate()
-{
-	validate(median_Step0);
-	validate(median_Step1);
-	validate(median_Step2);
-	validate(median_Step3);
-	validate(median_Parallel);
-	validate(median_Parallel_avx2);
-	validate(median_Parallel_step1);
-}
-
-int main(int argc, char** argv)
-{
-	init();
-	validate();
-	celero::Run(argc, argv);
-	return 0;
-}
-
-static constexpr auto BENCH_SAMPLES = 30;
-static constexpr auto BENCH_ITERATIONS = 1000;
-
-#if 0
-BASELINE(Median, Cpp, BENCH_SAMPLES, BENCH_ITERATIONS)
-{
-	median_Cpp(input_data, output_data, data_size);
-}
-
-BENCHMARK(Median, Step0, BENCH_SAMPLES, BENCH_ITERATIONS)
-{
-	median_Step0(input_data, output_data, data_size);
-}
-#else
-BASELINE(Median, Step0, BENCH_SAMPLES, BENCH_ITERATIONS)
-{
-	median_Step0(input_data, output_data, data_size);
-}
-#endif
-
-BENCHMARK(Median, Step1, BENCH_SAMPLES, BENCH_ITERATIONS)
-{
-	median_Step1(input_data, output_data, data_size);
-}
-
-BENCHMARK(Median, Step2, BENCH_SAMPLES, BENCH_ITERATIONS)
-{
-	median_Step2(input_data, output_data, data_size);
-}
-
-BENCHMARK(Median, Step3, BENCH_SAMPLES, BENCH_ITERATIONS)
-{
-	median_Step3(input_data, output_data, data_size);
-}
-
-BENCHMARK(Median, Parallel, BENCH_SAMPLES, BENCH_ITERATIONS)
-{
-	median_Parallel(input_data, output_data, data_size);
-}
-
-#if 0
-BENCHMARK(Median, ParallelAVX2, BENCH_SAMPLES, BENCH_ITERATIONS)
-{
-	median_Parallel_avx2(input_data, output_data, data_size);
-}
-#endif
-
-BENCHMARK(Median, ParallelStep1, BENCH_SAMPLES, BENCH_ITERATIONS)
-{
-	median_Parallel_step1(input_data, output_data, data_size);
-}
-
-BENCHMARK(Median, Memcpy, BENCH_SAMPLES, BENCH_ITERATIONS)
-{
-	float* psrc = input_data;
-	float* pdst = output_data;
-	size_t size = data_size;
-	while (size >= 16)
-	{
-		rf512 curr = load_value(psrc[0]);
-		store_to_address(pdst, curr);
-		psrc += 16;
-		pdst += 16;
-		size -= 16;
-	}
-}
+﻿#include "avx-median.h"
+#include "median_stream.h"
+#include "perf_counters.h"
+#include "sample_arena.h"
+#include <celero/Celero.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <limits>
+#include <vector>
+#include <cassert>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <csignal>
+#include <cstdio>
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static constexpr size_t data_size = 131069; // ~512 KB - fits in L2 cache; overreads are caught by validate_guarded()
+static constexpr size_t canary_size = 16; // keeps output_data on a 64-byte boundary
+static constexpr size_t output_data_size = data_size + 2 * canary_size;
+
+float* input_data;
+float* output_data;
+float* raw_output_data;
+float* golden_output_data;
+
+static void validate(void(*method)(const float*, float*, size_t), const float* golden = golden_output_data)
+{
+	std::fill_n((uint8_t*)raw_output_data, output_data_size * sizeof(raw_output_data[0]), 0xCD);
+	method(input_data, output_data, data_size);
+	if (!std::equal(raw_output_data, raw_output_data + output_data_size, golden))
+	{
+		assert(false);
+		std::cerr << "Validation failed\n";
+		for (int i = 0; i < canary_size; ++i)
+			std::cerr << "#" << i << ": " << raw_output_data[i] << "\t" << golden[i] << "\n";
+		for (int i = canary_size; i < canary_size + 32; ++i)
+			std::cerr << "#" << i << ": " << raw_output_data[i] << "\t" << golden[i] << "\t" << input_data[i - canary_size] << "\n";
+		for (int i = output_data_size - 16; i < output_data_size; ++i)
+			std::cerr << "#" << i << ": " << raw_output_data[i] << "\t" << golden[i] << "\n";
+		exit(1);
+	}
+}
+
+static float* alloc(size_t size)
+{
+	return reinterpret_cast<float*>(::operator new[](size * sizeof(float), std::align_val_t{ SampleArena::alignment }));
+}
+
+static float* make_golden(void(*reference)(const float*, float*, size_t))
+{
+	float* golden = alloc(output_data_size);
+	std::fill_n((uint8_t*)golden, output_data_size * sizeof(golden[0]), 0xCD);
+	reference(input_data, golden + canary_size, data_size);
+	return golden;
+}
+
+template<int Radius>
+static void median_Cpp_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	median_Cpp(psrc, pdst, buf_len, 2 * Radius + 1);
+}
+
+template<int Radius>
+static void validate_filter()
+{
+	static const float* golden = make_golden(median_Cpp_filter<Radius>);
+	validate(median_filter<Radius>, golden);
+}
+
+template<int W, int K>
+static void rank_Cpp_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	rank_Cpp(psrc, pdst, buf_len, W, K);
+}
+
+template<int W, int K>
+static void validate_rank()
+{
+	static const float* golden = make_golden(rank_Cpp_filter<W, K>);
+	validate(rank_filter<W, K>, golden);
+}
+
+//- Every rank of a shared pass must match its single-rank reference.
+//
+template<int W, int... K>
+static void validate_ranks()
+{
+	constexpr size_t ranks[] = { K... };
+	std::vector<float> golden(data_size);
+	std::vector<std::vector<float>> outputs(sizeof...(K), std::vector<float>(data_size));
+	float* pdsts[sizeof...(K)];
+	for (size_t i = 0; i < sizeof...(K); ++i)
+		pdsts[i] = outputs[i].data();
+
+	rank_filter<W, K...>(input_data, pdsts, data_size);
+	for (size_t i = 0; i < sizeof...(K); ++i)
+	{
+		rank_Cpp(input_data, golden.data(), data_size, W, ranks[i]);
+		if (outputs[i] != golden)
+		{
+			assert(false);
+			std::cerr << "Validation failed for rank " << ranks[i] << " of " << W << " in a shared pass\n";
+			exit(1);
+		}
+	}
+}
+
+//- The weighted medians against the scalar reference, which expands each tap into its weight.
+//
+template<int... Weights>
+static void weighted_Cpp_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	static const int weights[] = { Weights... };
+	weighted_median_Cpp(psrc, pdst, buf_len, weights);
+}
+
+template<int... Weights>
+static void validate_weighted()
+{
+	validate(weighted_median<Weights...>, make_golden(weighted_Cpp_filter<Weights...>));
+}
+
+//- The fused passes against as many median_Cpp passes; the root against the reference run to
+//  convergence, which must also agree on the number of passes that changed the signal.
+//
+static constexpr size_t root_max_passes = 64;
+
+template<size_t Passes>
+static void iterated_Cpp_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	iterated_median_Cpp(psrc, pdst, buf_len, Passes);
+}
+
+template<size_t Passes>
+static void iterated_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	iterated_median(psrc, pdst, buf_len, Passes);
+}
+
+static void root_Cpp_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	iterated_median_root_Cpp(psrc, pdst, buf_len, root_max_passes);
+}
+
+static void root_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	iterated_median_root(psrc, pdst, buf_len, root_max_passes);
+}
+
+static void validate_iterated()
+{
+	validate(iterated_filter<2>, make_golden(iterated_Cpp_filter<2>));
+	validate(iterated_filter<5>, make_golden(iterated_Cpp_filter<5>));
+	validate(iterated_filter<40>, make_golden(iterated_Cpp_filter<40>));
+	validate(root_filter, make_golden(root_Cpp_filter));
+
+	std::vector<float> output(data_size);
+	if (iterated_median_root(input_data, output.data(), data_size, root_max_passes)
+		!= iterated_median_root_Cpp(input_data, output.data(), data_size, root_max_passes))
+	{
+		assert(false);
+		std::cerr << "Validation failed for the pass count of iterated_median_root\n";
+		exit(1);
+	}
+}
+
+//- Erosion and dilation against rank_Cpp, and the fused opening and closing against two
+//  separate reference passes.
+//
+template<size_t Window, bool Max>
+static void extremum_Cpp_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	rank_Cpp(psrc, pdst, buf_len, Window, Max ? Window - 1 : 0);
+}
+
+template<size_t Window, bool Max>
+static void fused_Cpp_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	std::vector<float> first(buf_len);
+	extremum_Cpp_filter<Window, !Max>(psrc, first.data(), buf_len);
+	extremum_Cpp_filter<Window, Max>(first.data(), pdst, buf_len);
+}
+
+template<size_t Window, void(*Method)(const float*, float*, size_t, size_t)>
+static void morphology_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	Method(psrc, pdst, buf_len, Window);
+}
+
+template<size_t Window>
+static void validate_morphology()
+{
+	validate(morphology_filter<Window, min_filter>, make_golden(extremum_Cpp_filter<Window, false>));
+	validate(morphology_filter<Window, max_filter>, make_golden(extremum_Cpp_filter<Window, true>));
+	validate(morphology_filter<Window, opening_filter>, make_golden(fused_Cpp_filter<Window, true>));
+	validate(morphology_filter<Window, closing_filter>, make_golden(fused_Cpp_filter<Window, false>));
+}
+
+//- The 2D filters see the input as an image of 'image_width' columns whose rows are
+//  'image_src_stride' samples apart in the input and 'image_dst_stride' apart in the output;
+//  the gaps between rows must be left untouched.
+//
+static constexpr size_t image_width = 300;
+static constexpr size_t image_src_stride = 320;
+static constexpr size_t image_dst_stride = 317;
+
+template<int Radius>
+static void median_Cpp_image(const float* psrc, float* pdst, size_t buf_len)
+{
+	median_Cpp_2d(psrc, image_src_stride, pdst, image_dst_stride, image_width, buf_len / image_src_stride, 2 * Radius + 1);
+}
+
+template<int Radius>
+static void median_filter_image(const float* psrc, float* pdst, size_t buf_len)
+{
+	median_filter_2d<Radius>(psrc, image_src_stride, pdst, image_dst_stride, image_width, buf_len / image_src_stride);
+}
+
+template<int Radius>
+static void validate_filter_2d()
+{
+	static const float* golden = make_golden(median_Cpp_image<Radius>);
+	validate(median_filter_image<Radius>, golden);
+}
+
+//- The input seen as 'buf_len / Channels' frames of 'Channels' interleaved samples, and as every
+//  third sample filtered into every second output.
+//
+template<size_t Channels>
+static void median_Cpp_interleaved(const float* psrc, float* pdst, size_t buf_len)
+{
+	std::vector<float> channel(buf_len / Channels);
+	std::vector<float> filtered(buf_len / Channels);
+	for (size_t c = 0; c < Channels; ++c)
+	{
+		for (size_t i = 0; i < channel.size(); ++i)
+			channel[i] = psrc[i * Channels + c];
+		median_Cpp(channel.data(), filtered.data(), channel.size());
+		for (size_t i = 0; i < channel.size(); ++i)
+			pdst[i * Channels + c] = filtered[i];
+	}
+}
+
+template<size_t Channels>
+static void median_Parallel_channels(const float* psrc, float* pdst, size_t buf_len)
+{
+	median_Parallel_interleaved(psrc, pdst, buf_len / Channels, Channels);
+}
+
+template<size_t Channels>
+static void validate_interleaved()
+{
+	static const float* golden = make_golden(median_Cpp_interleaved<Channels>);
+	validate(median_Parallel_channels<Channels>, golden);
+}
+
+static void median_Cpp_strided(const float* psrc, float* pdst, size_t buf_len)
+{
+	std::vector<float> strided(buf_len / 3);
+	std::vector<float> filtered(buf_len / 3);
+	for (size_t i = 0; i < strided.size(); ++i)
+		strided[i] = psrc[i * 3];
+	median_Cpp(strided.data(), filtered.data(), strided.size());
+	for (size_t i = 0; i < strided.size(); ++i)
+		pdst[i * 2] = filtered[i];
+}
+
+static void median_Parallel_stride3(const float* psrc, float* pdst, size_t buf_len)
+{
+	median_Parallel_strided(psrc, 3, pdst, 2, buf_len / 3);
+}
+
+static void validate_strided()
+{
+	static const float* golden = make_golden(median_Cpp_strided);
+	validate(median_Parallel_stride3, golden);
+}
+
+//- The buffer cut into series of 1 .. 80 samples, or into rows between strides.
+//
+static size_t segment_length(size_t index)
+{
+	return index * 37 % 80 + 1;
+}
+
+static void median_Cpp_segments(const float* psrc, float* pdst, size_t buf_len)
+{
+	for (size_t i = 0, pos = 0; pos < buf_len; pos += segment_length(i++))
+		median_Cpp(psrc + pos, pdst + pos, std::min(segment_length(i), buf_len - pos), 7);
+}
+
+static void median_Batch_segments(const float* psrc, float* pdst, size_t buf_len)
+{
+	std::vector<const float*> srcs;
+	std::vector<float*> dsts;
+	std::vector<size_t> lens;
+	for (size_t i = 0, pos = 0; pos < buf_len; pos += segment_length(i++))
+	{
+		srcs.push_back(psrc + pos);
+		dsts.push_back(pdst + pos);
+		lens.push_back(std::min(segment_length(i), buf_len - pos));
+	}
+	median_batch(srcs.data(), dsts.data(), lens.data(), lens.size());
+}
+
+//- Rows of 'Len' samples, 'Len' + 3 apart in the input and 'Len' + 1 apart in the output: 200
+//  takes the median_Parallel path of median_rows, 37 and 80 the transposed tiles.
+//
+template<size_t Len>
+static void median_Cpp_matrix(const float* psrc, float* pdst, size_t buf_len)
+{
+	for (size_t row = 0; (row + 1) * (Len + 3) <= buf_len; ++row)
+		median_Cpp(psrc + row * (Len + 3), pdst + row * (Len + 1), Len, 7);
+}
+
+template<size_t Len>
+static void median_Rows_matrix(const float* psrc, float* pdst, size_t buf_len)
+{
+	median_rows(psrc, Len + 3, pdst, Len + 1, Len, buf_len / (Len + 3));
+}
+
+static void validate_batch()
+{
+	static const float* segments = make_golden(median_Cpp_segments);
+	validate(median_Batch_segments, segments);
+	validate(median_Rows_matrix<200>, make_golden(median_Cpp_matrix<200>));
+	validate(median_Rows_matrix<37>, make_golden(median_Cpp_matrix<37>));
+	validate(median_Rows_matrix<80>, make_golden(median_Cpp_matrix<80>));
+}
+
+template<size_t Window>
+static void median_Cpp_window(const float* psrc, float* pdst, size_t buf_len)
+{
+	median_Cpp(psrc, pdst, buf_len, Window);
+}
+
+template<size_t Window>
+static void median_Running_window(const float* psrc, float* pdst, size_t buf_len)
+{
+	median_Running(psrc, pdst, buf_len, Window);
+}
+
+template<size_t Window>
+static void validate_running()
+{
+	static const float* golden = make_golden(median_Cpp_window<Window>);
+	validate(median_Running_window<Window>, golden);
+}
+
+template<size_t Threads>
+static void median_Parallel_mt_threads(const float* psrc, float* pdst, size_t buf_len)
+{
+	median_Parallel_mt(psrc, pdst, buf_len, Threads);
+}
+
+template<typename T>
+static void median_Parallel_mt_typed(const T* psrc, T* pdst, size_t buf_len)
+{
+	median_Parallel_mt(psrc, pdst, buf_len, 4);
+}
+
+//- Forces the non-temporal stores of StreamingWriter whatever the length.
+//
+template<void(*Method)(const float*, float*, size_t, bool)>
+static void median_Streaming(const float* psrc, float* pdst, size_t buf_len)
+{
+	Method(psrc, pdst, buf_len, true);
+}
+
+//- The streaming stores at every misalignment of the destination: the output is written from
+//  1 .. 16 samples past the 64-byte aligned raw output buffer, and the samples on either side of
+//  it must be left untouched.
+//
+template<void(*Method)(const float*, float*, size_t, bool)>
+static void validate_streaming(const char* name)
+{
+	for (size_t offset = 1; offset <= 16; ++offset)
+	{
+		std::fill_n((uint8_t*)raw_output_data, output_data_size * sizeof(raw_output_data[0]), 0xCD);
+		Method(input_data, raw_output_data + offset, data_size, true);
+		if (!std::equal(raw_output_data + offset, raw_output_data + offset + data_size, golden_output_data + canary_size)
+			|| !std::all_of((uint8_t*)raw_output_data, (uint8_t*)(raw_output_data + offset), [](uint8_t b) { return b == 0xCD; })
+			|| !std::all_of((uint8_t*)(raw_output_data + offset + data_size), (uint8_t*)(raw_output_data + output_data_size),
+				[](uint8_t b) { return b == 0xCD; }))
+		{
+			assert(false);
+			std::cerr << "Validation failed for " << name << " streaming to an output " << offset << " samples past alignment\n";
+			exit(1);
+		}
+	}
+}
+
+//- Filters a copy of the input in place.
+//
+template<void(*Method)(const float*, float*, size_t)>
+static void median_InPlace(const float* psrc, float* pdst, size_t buf_len)
+{
+	std::copy_n(psrc, buf_len, pdst);
+	Method(pdst, pdst, buf_len);
+}
+
+//- Feeds the input through a MedianStream in packets of 'PacketLen' samples.
+//
+template<size_t PacketLen>
+static void median_Stream_packets(const float* psrc, float* pdst, size_t buf_len)
+{
+	MedianStream stream;
+	for (size_t pos = 0; pos < buf_len; pos += PacketLen)
+		pdst += stream.push(psrc + pos, std::min(PacketLen, buf_len - pos), pdst);
+	stream.flush(pdst);
+}
+
+//- Typed inputs spanning the full value range of T for the integer kernels, and the same
+//  [-1, 1] range as the float input for double.
+//
+template<typename T>
+static const std::vector<T>& typed_input()
+{
+	static const std::vector<T> input = []
+	{
+		std::mt19937 RandomDevice;
+		std::vector<T> values(data_size);
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			std::uniform_real_distribution<T> Distribution{ -1, 1 };
+			std::generate(values.begin(), values.end(), [&]() { return Distribution(RandomDevice); });
+		}
+		else
+		{
+			std::uniform_int_distribution<int64_t> Distribution{ std::numeric_limits<T>::min(), std::numeric_limits<T>::max() };
+			std::generate(values.begin(), values.end(), [&]() { return (T)Distribution(RandomDevice); });
+		}
+		return values;
+	}();
+	return input;
+}
+
+template<typename T>
+static std::vector<T>& typed_output()
+{
+	static std::vector<T> output(data_size);
+	return output;
+}
+
+template<typename T>
+static void validate_typed(void(*method)(const T*, T*, size_t))
+{
+	const std::vector<T>& input = typed_input<T>();
+	std::vector<T> golden(output_data_size);
+	std::vector<T> output(output_data_size);
+	std::fill_n((uint8_t*)golden.data(), output_data_size * sizeof(T), 0xCD);
+	std::fill_n((uint8_t*)output.data(), output_data_size * sizeof(T), 0xCD);
+	median_Cpp(input.data(), golden.data() + canary_size, data_size);
+	method(input.data(), output.data() + canary_size, data_size);
+	if (output != golden)
+	{
+		assert(false);
+		std::cerr << "Validation failed for " << sizeof(T) * 8 << "-bit samples\n";
+		for (size_t i = 0; i < output_data_size; ++i)
+			if (output[i] != golden[i])
+			{
+				std::cerr << "#" << i << ": " << +output[i] << "\t" << +golden[i] << "\n";
+				break;
+			}
+		exit(1);
+	}
+}
+
+//- The NaN policies, on a hand-checked sequence with isolated NaN, a run of 7 (an all-NaN
+//  window) and infinities, then on the whole input with sensor dropouts against median_Cpp<Policy>.
+//  Outputs are compared bit for bit, since NaN != NaN.
+//
+static constexpr float nan_sample = std::numeric_limits<float>::quiet_NaN();
+static constexpr float inf_sample = std::numeric_limits<float>::infinity();
+
+static constexpr float nan_golden_input[] =
+{
+	6, 8, 1, 7, 3, 2, 5, 4, 4, nan_sample, 1, 3, nan_sample, nan_sample, 2, 9, nan_sample, 5,
+	nan_sample, nan_sample, nan_sample, nan_sample, nan_sample, nan_sample, nan_sample, -inf_sample, 7, inf_sample,
+};
+
+static constexpr size_t nan_golden_size = sizeof(nan_golden_input) / sizeof(nan_golden_input[0]);
+
+template<NanPolicy Policy>
+static const float* nan_golden_output()
+{
+	static constexpr float N = nan_sample;
+	static constexpr float I = inf_sample;
+	static constexpr float propagate[nan_golden_size] = { 6, 6, 6, 5, 4, 4, N, N, N, N, N, N, N, N, N, N, N, N, N, N, N, N, N, N, N, N, N, N };
+	static constexpr float ignore[nan_golden_size] = { 6, 6, 6, 5, 4, 4, 4, 3.5, 3.5, 4, 3.5, 2.5, 2.5, 2.5, 4, 5, 5, 5, 7, 5, 5, N, -I, -I, 7, I, I, I };
+	static constexpr float as_infinity[nan_golden_size] = { 6, 6, 6, 5, 4, 4, 4, 4, 4, 4, 4, 4, 9, 9, 9, I, I, I, I, I, I, I, I, I, I, I, I, I };
+
+	if constexpr (Policy == NanPolicy::Propagate)
+		return propagate;
+	else if constexpr (Policy == NanPolicy::Ignore)
+		return ignore;
+	else
+		return as_infinity;
+}
+
+static const std::vector<float>& dropout_input()
+{
+	static const std::vector<float> input = []
+	{
+		std::mt19937 RandomDevice;
+		std::vector<float> values(input_data, input_data + data_size);
+		for (size_t pos = RandomDevice() % 256; pos < data_size; pos += RandomDevice() % 256)
+		{
+			size_t const run = RandomDevice() % 9 + 1;
+			std::fill_n(values.begin() + pos, std::min(run, data_size - pos), (run == 9) ? -inf_sample : nan_sample);
+			pos += run;
+		}
+		values[data_size / 2] = inf_sample;
+		return values;
+	}();
+	return input;
+}
+
+template<NanPolicy Policy>
+static void validate_nan(const char* name, void(*method)(const float*, float*, size_t))
+{
+	std::vector<float> output(nan_golden_size);
+	method(nan_golden_input, output.data(), nan_golden_size);
+	bool passed = std::memcmp(output.data(), nan_golden_output<Policy>(), nan_golden_size * sizeof(float)) == 0;
+
+	const std::vector<float>& input = dropout_input();
+	std::vector<float> golden(output_data_size);
+	output.resize(output_data_size);
+	std::fill_n((uint8_t*)golden.data(), output_data_size * sizeof(float), 0xCD);
+	std::fill_n((uint8_t*)output.data(), output_data_size * sizeof(float), 0xCD);
+	median_Cpp<Policy>(input.data(), golden.data() + canary_size, data_size);
+	method(input.data(), output.data() + canary_size, data_size);
+	passed = passed && std::memcmp(output.data(), golden.data(), output_data_size * sizeof(float)) == 0;
+
+	if (!passed)
+	{
+		assert(false);
+		std::cerr << "Validation failed for " << name << "\n";
+		exit(1);
+	}
+}
+
+//- The boundary modes, on a hand-checked sequence, then on every length up to 40 (where the
+//  short-buffer paths and the padded ends overlap) and on the whole input against
+//  median_Cpp<Mode>, in place as well.
+//
+static constexpr float boundary_golden_input[] = { 9, 1, 6, 3, 8, 2, 7, 5 };
+static constexpr size_t boundary_golden_size = sizeof(boundary_golden_input) / sizeof(boundary_golden_input[0]);
+
+template<BoundaryMode Mode>
+static const float* boundary_golden_output()
+{
+	static constexpr float replicate[boundary_golden_size] = { 9, 8, 6, 6, 5, 5, 5, 5 };
+	static constexpr float reflect[boundary_golden_size] = { 6, 6, 6, 6, 5, 5, 5, 5 };
+	static constexpr float mirror[boundary_golden_size] = { 3, 6, 3, 6, 5, 6, 5, 7 };
+	static constexpr float wrap[boundary_golden_size] = { 5, 6, 5, 6, 5, 6, 5, 6 };
+	static constexpr float constant[boundary_golden_size] = { 1, 3, 3, 6, 5, 5, 3, 2 };
+	static constexpr float valid[boundary_golden_size] = { 6, 5 };
+
+	if constexpr (Mode == BoundaryMode::Replicate)
+		return replicate;
+	else if constexpr (Mode == BoundaryMode::Reflect)
+		return reflect;
+	else if constexpr (Mode == BoundaryMode::Mirror)
+		return mirror;
+	else if constexpr (Mode == BoundaryMode::Wrap)
+		return wrap;
+	else if constexpr (Mode == BoundaryMode::Constant)
+		return constant;
+	else
+		return valid;
+}
+
+template<typename T>
+static constexpr T boundary_constant = T(3);
+
+template<BoundaryMode Mode, typename T>
+static void median_Boundary(const T* psrc, T* pdst, size_t buf_len)
+{
+	median_Parallel<Mode>(psrc, pdst, buf_len, boundary_constant<T>);
+}
+
+template<BoundaryMode Mode, typename T>
+static void median_Cpp_boundary(const T* psrc, T* pdst, size_t buf_len)
+{
+	median_Cpp<Mode>(psrc, pdst, buf_len, boundary_constant<T>);
+}
+
+template<BoundaryMode Mode, typename T>
+static void validate_boundary(const char* name)
+{
+	bool passed = true;
+
+	if constexpr (std::is_same_v<T, float>)
+	{
+		size_t const outputs = (Mode == BoundaryMode::Valid) ? boundary_golden_size - 6 : boundary_golden_size;
+		float output[boundary_golden_size];
+		median_Cpp<Mode>(boundary_golden_input, output, boundary_golden_size, 0.0f);
+		passed = std::equal(output, output + outputs, boundary_golden_output<Mode>());
+		median_Parallel<Mode>(boundary_golden_input, output, boundary_golden_size, 0.0f);
+		passed = passed && std::equal(output, output + outputs, boundary_golden_output<Mode>());
+	}
+
+	const std::vector<T>& input = typed_input<T>();
+	std::vector<T> golden(output_data_size);
+	std::vector<T> output(output_data_size);
+	for (size_t len = 0; len <= 40; ++len)
+	{
+		std::fill_n((uint8_t*)golden.data(), output_data_size * sizeof(T), 0xCD);
+		std::fill_n((uint8_t*)output.data(), output_data_size * sizeof(T), 0xCD);
+		median_Cpp_boundary<Mode>(input.data(), golden.data() + canary_size, len);
+		median_Boundary<Mode>(input.data(), output.data() + canary_size, len);
+		passed = passed && output == golden;
+	}
+
+	std::fill_n((uint8_t*)golden.data(), output_data_size * sizeof(T), 0xCD);
+	std::fill_n((uint8_t*)output.data(), output_data_size * sizeof(T), 0xCD);
+	median_Cpp_boundary<Mode>(input.data(), golden.data() + canary_size, data_size);
+	median_Boundary<Mode>(input.data(), output.data() + canary_size, data_size);
+	passed = passed && output == golden;
+
+	size_t const outputs = (Mode == BoundaryMode::Valid) ? data_size - 6 : data_size;
+	std::copy(input.begin(), input.end(), output.begin() + canary_size);
+	median_Boundary<Mode>(output.data() + canary_size, output.data() + canary_size, data_size);
+	passed = passed && std::equal(golden.begin() + canary_size, golden.begin() + canary_size + outputs, output.begin() + canary_size);
+
+	if (!passed)
+	{
+		assert(false);
+		std::cerr << "Validation failed for " << name << " on " << sizeof(T) * 8 << "-bit samples\n";
+		exit(1);
+	}
+}
+
+template<BoundaryMode Mode>
+static void validate_boundary(const char* name)
+{
+	validate_boundary<Mode, float>(name);
+	validate_boundary<Mode, uint8_t>(name);
+	validate_boundary<Mode, int16_t>(name);
+	validate_boundary<Mode, uint16_t>(name);
+	validate_boundary<Mode, int32_t>(name);
+}
+
+//- The Hampel filter on the input with spikes added, outputs and outlier bits against
+//  hampel_Cpp, then in place. Bytes of the bitmask past (len + 7) / 8 must stay untouched.
+//
+static constexpr float hampel_threshold = 3.0f;
+
+static const std::vector<float>& spiky_input()
+{
+	static const std::vector<float> input = []
+	{
+		std::mt19937 RandomDevice;
+		std::vector<float> values(input_data, input_data + data_size);
+		for (size_t pos = RandomDevice() % 64; pos < data_size; pos += RandomDevice() % 64 + 1)
+			values[pos] += (RandomDevice() & 1) ? 10.0f : -10.0f;
+		return values;
+	}();
+	return input;
+}
+
+static void hampel_Cpp_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	hampel_Cpp(psrc, pdst, buf_len, hampel_threshold);
+}
+
+static void hampel_Parallel_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+	hampel_filter(psrc, pdst, buf_len, hampel_threshold);
+}
+
+static void validate_hampel()
+{
+	const std::vector<float>& input = spiky_input();
+	size_t const mask_size = (data_size + 7) / 8;
+	std::vector<float> golden(data_size);
+	std::vector<float> output(data_size);
+	std::vector<uint8_t> golden_mask(mask_size + canary_size, 0xCD);
+	std::vector<uint8_t> mask(mask_size + canary_size, 0xCD);
+
+	hampel_Cpp(input.data(), golden.data(), data_size, hampel_threshold, golden_mask.data());
+	hampel_filter(input.data(), output.data(), data_size, hampel_threshold, mask.data());
+	bool passed = output == golden && mask == golden_mask;
+
+	output = input;
+	hampel_filter(output.data(), output.data(), data_size, hampel_threshold);
+	passed = passed && output == golden;
+
+	if (!passed)
+	{
+		assert(false);
+		std::cerr << "Validation failed for hampel_filter\n";
+		exit(1);
+	}
+}
+
+//- Pages that fault on any access on either side of a buffer, so that a kernel reading or
+//  writing a single byte outside its input or output crashes instead of passing validation.
+//
+class GuardedPages
+{
+public:
+	explicit GuardedPages(size_t bytes)
+	{
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		page = info.dwPageSize;
+		size = (bytes + page - 1) / page * page + 2 * page;
+		base = static_cast<char*>(VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_NOACCESS));
+		DWORD previous;
+		VirtualProtect(base + page, size - 2 * page, PAGE_READWRITE, &previous);
+#else
+		page = (size_t)sysconf(_SC_PAGESIZE);
+		size = (bytes + page - 1) / page * page + 2 * page;
+		base = static_cast<char*>(mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		mprotect(base + page, size - 2 * page, PROT_READ | PROT_WRITE);
+#endif
+	}
+
+	~GuardedPages()
+	{
+#ifdef _WIN32
+		VirtualFree(base, 0, MEM_RELEASE);
+#else
+		munmap(base, size);
+#endif
+	}
+
+	//- 'count' elements starting right after the leading guard page, or ending right before the
+	//  trailing one.
+	//
+	template<typename T>
+	T* place(size_t count, bool at_end) const
+	{
+		return at_end ? reinterpret_cast<T*>(base + size - page) - count : reinterpret_cast<T*>(base + page);
+	}
+
+	char* base = nullptr;
+	size_t size = 0;
+	size_t page = 0;
+};
+
+//- Runs a kernel over random lengths, with input and output each placed either against the
+//  leading or the trailing guard page. Most lengths are short, where the tails of the vectorised
+//  loops are; a quarter go up to 'guarded_max_len'. A fault is reported with the kernel and the
+//  trial that caused it. Every run does a quick pass; set MEDIAN_GUARD_TRIALS to fuzz longer
+//  (3000 trials of every kernel take about 10 s).
+//
+static constexpr size_t guarded_max_len = 4096;
+
+static size_t guarded_trials = 250;
+static const char* guarded_name = nullptr;
+static size_t guarded_len = 0;
+static bool guarded_src_at_end = false;
+static bool guarded_dst_at_end = false;
+
+extern "C" void guarded_fault(int)
+{
+	std::fprintf(stderr, "Out of bounds access by %s: %zu samples, input at the %s guard, output at the %s guard\n",
+		guarded_name, guarded_len, guarded_src_at_end ? "trailing" : "leading", guarded_dst_at_end ? "trailing" : "leading");
+	std::_Exit(1);
+}
+
+template<typename T>
+static const T* guarded_input()
+{
+	if constexpr (std::is_same_v<T, float>)
+		return input_data;
+	else
+		return typed_input<T>().data();
+}
+
+template<typename T>
+static void validate_guarded(const char* name, void(*method)(const T*, T*, size_t), void(*reference)(const T*, T*, size_t) = median_Cpp)
+{
+	static const GuardedPages src_pages(guarded_max_len * sizeof(T));
+	static const GuardedPages dst_pages(guarded_max_len * sizeof(T));
+
+	std::mt19937 RandomDevice;
+	std::vector<T> golden(guarded_max_len);
+	guarded_name = name;
+	for (size_t trial = 0; trial < guarded_trials; ++trial)
+	{
+		size_t const len = RandomDevice() % 4 ? RandomDevice() % 129 : RandomDevice() % (guarded_max_len + 1);
+		guarded_len = len;
+		guarded_src_at_end = RandomDevice() & 1;
+		guarded_dst_at_end = RandomDevice() & 1;
+
+		T* const psrc = src_pages.place<T>(len, guarded_src_at_end);
+		T* const pdst = dst_pages.place<T>(len, guarded_dst_at_end);
+		std::copy_n(guarded_input<T>() + RandomDevice() % (data_size - len), len, psrc);
+		std::fill_n((uint8_t*)golden.data(), len * sizeof(T), 0xCD);
+		std::fill_n((uint8_t*)pdst, len * sizeof(T), 0xCD);
+		reference(psrc, golden.data(), len);
+		method(psrc, pdst, len);
+		if (!std::equal(pdst, pdst + len, golden.data()))
+		{
+			assert(false);
+			std::cerr << "Validation failed for " << name << " on " << len << " guarded samples\n";
+			exit(1);
+		}
+	}
+	guarded_name = nullptr;
+}
+
+static void validate_guarded()
+{
+	if (const char* trials = std::getenv("MEDIAN_GUARD_TRIALS"))
+		guarded_trials = std::strtoul(trials, nullptr, 10);
+	std::signal(SIGSEGV, guarded_fault);
+#ifdef SIGBUS
+	std::signal(SIGBUS, guarded_fault);
+#endif
+
+	validate_guarded<float>("median7", median7);
+	validate_guarded<float>("median_Cpp in place", median_InPlace<median_Cpp>);
+	validate_guarded<float>("median_Running", median_Running_window<7>);
+	validate_guarded<float>("median_Running<31>", median_Running_window<31>, median_Cpp_window<31>);
+
+	if (median_kernel_supported(MedianKernel::AVX2))
+	{
+		validate_guarded<float>("median_Parallel_avx2", median_Parallel_avx2);
+		validate_guarded<uint8_t>("median_Parallel_avx2<uint8_t>", median_Parallel_avx2);
+		validate_guarded<int16_t>("median_Parallel_avx2<int16_t>", median_Parallel_avx2);
+		validate_guarded<uint16_t>("median_Parallel_avx2<uint16_t>", median_Parallel_avx2);
+		validate_guarded<int32_t>("median_Parallel_avx2<int32_t>", median_Parallel_avx2);
+		validate_guarded<double>("median_Parallel_avx2<double>", median_Parallel_avx2);
+		validate_guarded<double>("median_Parallel_step1_avx2<double>", median_Parallel_step1_avx2);
+	}
+
+	if (median_kernel_supported(MedianKernel::AVX512))
+	{
+		validate_guarded<float>("median_Step0", median_Step0);
+		validate_guarded<float>("median_Step1", median_Step1);
+		validate_guarded<float>("median_Step2", median_Step2);
+		validate_guarded<float>("median_Step3", median_Step3);
+		validate_guarded<float>("median_Parallel", median_Parallel);
+		validate_guarded<float>("median_Parallel_step1", median_Parallel_step1);
+		validate_guarded<float>("median_Parallel_step1_aligned", median_Parallel_step1_aligned);
+		validate_guarded<float>("median_Parallel streaming", median_Streaming<median_Parallel>);
+		validate_guarded<float>("median_Parallel_step1 streaming", median_Streaming<median_Parallel_step1>);
+		validate_guarded<float>("median_Parallel_mt", median_Parallel_mt_threads<4>);
+		validate_guarded<float>("median_Parallel in place", median_InPlace<median_Parallel>);
+		validate_guarded<float>("median_Parallel_step1 in place", median_InPlace<median_Parallel_step1>);
+		validate_guarded<float>("iterated_median", iterated_filter<5>, iterated_Cpp_filter<5>);
+		validate_guarded<float>("iterated_median in place", median_InPlace<iterated_filter<5>>, iterated_Cpp_filter<5>);
+		validate_guarded<float>("iterated_median_root", root_filter, root_Cpp_filter);
+		validate_guarded<float>("iterated_median_root in place", median_InPlace<root_filter>, root_Cpp_filter);
+		validate_guarded<float>("MedianStream", median_Stream_packets<5>);
+		validate_guarded<float>("median_filter<1>", median_filter<1>, median_Cpp_filter<1>);
+		validate_guarded<float>("median_filter<3>", median_filter<3>, median_Cpp_filter<3>);
+		validate_guarded<float>("median_filter<12>", median_filter<12>, median_Cpp_filter<12>);
+		validate_guarded<float>("rank_filter<3, 0>", rank_filter<3, 0>, rank_Cpp_filter<3, 0>);
+		validate_guarded<float>("rank_filter<13, 6>", rank_filter<13, 6>, rank_Cpp_filter<13, 6>);
+		validate_guarded<float>("rank_filter<15, 14>", rank_filter<15, 14>, rank_Cpp_filter<15, 14>);
+		validate_guarded<float>("min_filter", morphology_filter<31, min_filter>, extremum_Cpp_filter<31, false>);
+		validate_guarded<float>("opening_filter", morphology_filter<31, opening_filter>, fused_Cpp_filter<31, true>);
+		validate_guarded<float>("closing_filter", morphology_filter<5, closing_filter>, fused_Cpp_filter<5, false>);
+		validate_guarded<float>("hampel_filter", hampel_Parallel_filter, hampel_Cpp_filter);
+		validate_guarded<float>("weighted_median", weighted_median<1, 2, 2, 3, 2, 2, 1>, weighted_Cpp_filter<1, 2, 2, 3, 2, 2, 1>);
+		validate_guarded<float>("center_weighted_median<3>", center_weighted_median<3>, weighted_Cpp_filter<1, 1, 1, 3, 1, 1, 1>);
+		validate_guarded<float>("median_filter_2d<1>", median_filter_image<1>, median_Cpp_image<1>);
+		validate_guarded<float>("median_filter_2d<3>", median_filter_image<3>, median_Cpp_image<3>);
+		validate_guarded<float>("median_Parallel_interleaved", median_Parallel_channels<3>, median_Cpp_interleaved<3>);
+		validate_guarded<float>("median_Parallel_strided", median_Parallel_stride3, median_Cpp_strided);
+		validate_guarded<float>("median_Parallel<Propagate>", median_Parallel<NanPolicy::Propagate>);
+		validate_guarded<float>("median_Parallel<Ignore>", median_Parallel<NanPolicy::Ignore>);
+		validate_guarded<float>("median_Parallel<AsInfinity>", median_Parallel<NanPolicy::AsInfinity>);
+		validate_guarded<float>("median_Parallel<Reflect>", median_Boundary<BoundaryMode::Reflect>, median_Cpp_boundary<BoundaryMode::Reflect>);
+		validate_guarded<float>("median_Parallel<Mirror>", median_Boundary<BoundaryMode::Mirror>, median_Cpp_boundary<BoundaryMode::Mirror>);
+		validate_guarded<float>("median_Parallel<Wrap>", median_Boundary<BoundaryMode::Wrap>, median_Cpp_boundary<BoundaryMode::Wrap>);
+		validate_guarded<float>("median_Parallel<Constant>", median_Boundary<BoundaryMode::Constant>, median_Cpp_boundary<BoundaryMode::Constant>);
+		validate_guarded<float>("median_Parallel<Valid>", median_Boundary<BoundaryMode::Valid>, median_Cpp_boundary<BoundaryMode::Valid>);
+		validate_guarded<uint8_t>("median_Parallel<Mirror, uint8_t>", median_Boundary<BoundaryMode::Mirror>, median_Cpp_boundary<BoundaryMode::Mirror>);
+		validate_guarded<int16_t>("median_Parallel<Valid, int16_t>", median_Boundary<BoundaryMode::Valid>, median_Cpp_boundary<BoundaryMode::Valid>);
+		validate_guarded<float>("median_batch", median_Batch_segments, median_Cpp_segments);
+		validate_guarded<float>("median_rows", median_Rows_matrix<200>, median_Cpp_matrix<200>);
+		validate_guarded<float>("median_rows<37>", median_Rows_matrix<37>, median_Cpp_matrix<37>);
+		validate_guarded<uint8_t>("median_Parallel<uint8_t>", median_Parallel);
+		validate_guarded<int16_t>("median_Parallel<int16_t>", median_Parallel);
+		validate_guarded<uint16_t>("median_Parallel<uint16_t>", median_Parallel);
+		validate_guarded<int32_t>("median_Parallel<int32_t>", median_Parallel);
+		validate_guarded<double>("median_Parallel<double>", median_Parallel);
+		validate_guarded<double>("median_Parallel_step1<double>", median_Parallel_step1);
+	}
+
+	std::signal(SIGSEGV, SIG_DFL);
+#ifdef SIGBUS
+	std::signal(SIGBUS, SIG_DFL);
+#endif
+}
+
+static void init()
+{
+	std::mt19937 RandomDevice;
+	std::uniform_real_distribution<float> Distribution{ -1, 1 };
+	input_data = alloc(data_size);
+	raw_output_data = alloc(output_data_size);
+	golden_output_data = alloc(output_data_size);
+
+	std::generate_n(input_data, data_size, [&]() {return Distribution(RandomDevice); });
+
+	std::fill_n((uint8_t*)raw_output_data, output_data_size * sizeof(raw_output_data[0]), 0xCD);
+	output_data = raw_output_data + canary_size;
+	median_Cpp(input_data, output_data, data_size);
+	std::copy_n(raw_output_data, output_data_size, golden_output_data);
+}
+
+static void validate()
+{
+	validate(median7);
+	validate(median_InPlace<median7>);
+	validate(median_InPlace<median_Cpp>);
+	validate(median_Cpp_filter<3>);
+	validate(median_Running_window<7>);
+	validate_nan<NanPolicy::Propagate>("median_Cpp<Propagate>", median_Cpp<NanPolicy::Propagate>);
+	validate_nan<NanPolicy::Ignore>("median_Cpp<Ignore>", median_Cpp<NanPolicy::Ignore>);
+	validate_nan<NanPolicy::AsInfinity>("median_Cpp<AsInfinity>", median_Cpp<NanPolicy::AsInfinity>);
+	validate_running<31>();
+	validate_running<255>();
+
+	if (median_kernel_supported(MedianKernel::AVX2))
+	{
+		validate(median_Parallel_avx2);
+		validate(median_InPlace<median_Parallel_avx2>);
+		validate_typed<uint8_t>(median_Parallel_avx2);
+		validate_typed<int16_t>(median_Parallel_avx2);
+		validate_typed<uint16_t>(median_Parallel_avx2);
+		validate_typed<int32_t>(median_Parallel_avx2);
+		validate_typed<double>(median_Parallel_avx2);
+		validate_typed<double>(median_Parallel_step1_avx2);
+	}
+
+	//- On hosts without AVX-512 only the Dispatch and RunningMedian benchmark groups can run.
+	//
+	if (median_kernel_supported(MedianKernel::AVX512))
+	{
+		validate(median_Step0);
+		validate(median_Step1);
+		validate(median_Step2);
+		validate(median_Step3);
+		validate(median_Parallel);
+		validate(median_Parallel_step1);
+		validate(median_Parallel_step1_aligned);
+		validate(median_Streaming<median_Parallel>);
+		validate(median_Streaming<median_Parallel_step1>);
+		validate_streaming<median_Parallel>("median_Parallel");
+		validate_streaming<median_Parallel_step1>("median_Parallel_step1");
+		validate(median_Parallel_mt_threads<1>);
+		validate(median_Parallel_mt_threads<4>);
+		validate(median_InPlace<median_Parallel>);
+		validate(median_InPlace<median_Parallel_step1>);
+		validate(median_InPlace<median_Parallel_mt_threads<4>>);
+		validate(median_Stream_packets<1024>);
+		validate(median_Stream_packets<5>);
+
+		validate(median_filter<3>);
+		validate_filter<1>();
+		validate_filter<2>();
+		validate_filter<3>();
+		validate_filter<4>();
+		validate_filter<5>();
+		validate_filter<6>();
+		validate_filter<7>();
+		validate_filter<8>();
+		validate_filter<9>();
+		validate_filter<10>();
+		validate_filter<11>();
+		validate_filter<12>();
+		validate_filter_2d<1>();
+		validate_filter_2d<2>();
+		validate_filter_2d<3>();
+		validate(rank_filter<7, 3>);
+		validate_rank<3, 0>();
+		validate_rank<3, 2>();
+		validate_rank<5, 1>();
+		validate_rank<7, 0>();
+		validate_rank<7, 5>();
+		validate_rank<9, 1>();
+		validate_rank<11, 9>();
+		validate_rank<13, 2>();
+		validate_rank<13, 6>();
+		validate_rank<15, 0>();
+		validate_rank<15, 7>();
+		validate_rank<15, 14>();
+		validate_ranks<7, 0, 3, 6>();
+		validate_ranks<11, 0, 1, 5, 9, 10>();
+		validate_ranks<15, 0, 1, 7, 13, 14>();
+		validate_morphology<3>();
+		validate_morphology<31>();
+		validate_hampel();
+		validate(weighted_median<1, 1, 1, 1, 1, 1, 1>);
+		validate(center_weighted_median<1>);
+		validate_weighted<0, 1, 1, 1, 1, 1, 0>();
+		validate_weighted<1, 2, 2, 3, 2, 2, 1>();
+		validate_weighted<1, 2, 3, 5, 3, 2, 1>();
+		validate(center_weighted_median<3>, make_golden(weighted_Cpp_filter<1, 1, 1, 3, 1, 1, 1>));
+		validate(center_weighted_median<5>, make_golden(weighted_Cpp_filter<1, 1, 1, 5, 1, 1, 1>));
+		validate_iterated();
+
+		validate_interleaved<2>();
+		validate_interleaved<3>();
+		validate_interleaved<4>();
+		validate_interleaved<5>();
+		validate_strided();
+		validate_batch();
+
+		validate_typed<uint8_t>(median_Parallel);
+		validate_typed<int16_t>(median_Parallel);
+		validate_typed<uint16_t>(median_Parallel);
+		validate_typed<int32_t>(median_Parallel);
+		validate_typed<uint8_t>(median_Parallel_mt_typed<uint8_t>);
+		validate_typed<int16_t>(median_Parallel_mt_typed<int16_t>);
+		validate_typed<double>(median_Parallel);
+		validate_typed<double>(median_Parallel_step1);
+
+		validate_nan<NanPolicy::Propagate>("median_Parallel<Propagate>", median_Parallel<NanPolicy::Propagate>);
+		validate_nan<NanPolicy::Ignore>("median_Parallel<Ignore>", median_Parallel<NanPolicy::Ignore>);
+		validate_nan<NanPolicy::AsInfinity>("median_Parallel<AsInfinity>", median_Parallel<NanPolicy::AsInfinity>);
+		validate(median_Parallel<NanPolicy::Unchecked>);
+
+		validate_boundary<BoundaryMode::Replicate>("median_Parallel<Replicate>");
+		validate_boundary<BoundaryMode::Reflect>("median_Parallel<Reflect>");
+		validate_boundary<BoundaryMode::Mirror>("median_Parallel<Mirror>");
+		validate_boundary<BoundaryMode::Wrap>("median_Parallel<Wrap>");
+		validate_boundary<BoundaryMode::Constant>("median_Parallel<Constant>");
+		validate_boundary<BoundaryMode::Valid>("median_Parallel<Valid>");
+	}
+	else
+	{
+		std::cerr << "AVX-512 is not supported by this CPU; AVX-512 kernels not validated\n";
+	}
+
+	validate_guarded();
+}
+
+int main(int argc, char** argv)
+{
+	init();
+	std::cout << "median7 kernel: " << median_kernel_name(median7_kernel()) << "\n";
+	validate();
+	celero::Run(argc, argv);
+	return 0;
+}
+
+static constexpr auto BENCH_SAMPLES = 30;
+static constexpr auto BENCH_ITERATIONS = 1000;
+
+//- Hardware event counts around every sample of the Median group, when MEDIAN_PERF_COUNTERS is
+//  set in the environment and the kernel grants access to the counters: cycles and uops per
+//  output sample, IPC, and cache misses per 1000 samples. They are reported as user defined
+//  measurements, next to the timings on the console and as extra columns in the CSV written with
+//  -t. The problem space is the number of samples per call, so the throughput column reads as
+//  samples/s.
+//
+class CounterMeasurement : public celero::UserDefinedMeasurementTemplate<double>
+{
+public:
+	explicit CounterMeasurement(const char* name) : name(name)
+	{}
+
+	std::string getName() const override
+	{
+		return name;
+	}
+
+	const char* name;
+};
+
+struct CounterRatio
+{
+	const char* name;
+	PerfCounters::Event numerator;
+	PerfCounters::Event denominator;	// event_count: per output sample
+	double scale;
+};
+
+static constexpr CounterRatio counter_ratios[] =
+{
+	{ "cycles/sample", PerfCounters::Cycles, PerfCounters::event_count, 1.0 },
+	{ "IPC", PerfCounters::Instructions, PerfCounters::Cycles, 1.0 },
+	{ "uops/sample", PerfCounters::Uops, PerfCounters::event_count, 1.0 },
+	{ "port 5 uops/sample", PerfCounters::Port5Uops, PerfCounters::event_count, 1.0 },
+	{ "L1D misses/1K samples", PerfCounters::L1DMisses, PerfCounters::event_count, 1000.0 },
+	{ "L2 misses/1K samples", PerfCounters::L2Misses, PerfCounters::event_count, 1000.0 },
+	{ "LLC misses/1K samples", PerfCounters::LLCMisses, PerfCounters::event_count, 1000.0 },
+};
+
+class CounterFixture : public celero::TestFixture
+{
+public:
+	CounterFixture()
+	{
+		static PerfCounters* const shared = std::getenv("MEDIAN_PERF_COUNTERS") ? new PerfCounters() : nullptr;
+
+		if (shared == nullptr || !shared->any_available())
+			return;
+		counters = shared;
+		for (const CounterRatio& ratio : counter_ratios)
+		{
+			if (counters->available(ratio.numerator) &&
+				(ratio.denominator == PerfCounters::event_count || counters->available(ratio.denominator)))
+			{
+				ratios.push_back(&ratio);
+				measurements.push_back(std::make_shared<CounterMeasurement>(ratio.name));
+			}
+		}
+	}
+
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { { (int64_t)data_size, BENCH_ITERATIONS } };
+	}
+
+	void setUp(const celero::TestFixture::ExperimentValue& experimentValue) override
+	{
+		samples = (double)experimentValue.Value * (double)experimentValue.Iterations;
+		if (counters)
+			counters->start();
+	}
+
+	void tearDown() override
+	{
+		if (!counters)
+			return;
+		counters->stop();
+		for (size_t i = 0; i < ratios.size(); ++i)
+		{
+			double const denominator = (ratios[i]->denominator == PerfCounters::event_count) ? samples : counters->value(ratios[i]->denominator);
+			if (denominator > 0.0)
+				measurements[i]->addValue(ratios[i]->scale * counters->value(ratios[i]->numerator) / denominator);
+		}
+	}
+
+	std::vector<std::shared_ptr<celero::UserDefinedMeasurement>> getUserDefinedMeasurements() const override
+	{
+		return { measurements.begin(), measurements.end() };
+	}
+
+	PerfCounters* counters = nullptr;
+	std::vector<const CounterRatio*> ratios;
+	std::vector<std::shared_ptr<CounterMeasurement>> measurements;
+	double samples = 0.0;
+};
+
+#if 0
+BASELINE_F(Median, Cpp, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Cpp(input_data, output_data, data_size);
+}
+
+BENCHMARK_F(Median, Step0, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Step0(input_data, output_data, data_size);
+}
+#else
+BASELINE_F(Median, Step0, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Step0(input_data, output_data, data_size);
+}
+#endif
+
+BENCHMARK_F(Median, Step1, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Step1(input_data, output_data, data_size);
+}
+
+BENCHMARK_F(Median, Step2, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Step2(input_data, output_data, data_size);
+}
+
+BENCHMARK_F(Median, Step3, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Step3(input_data, output_data, data_size);
+}
+
+BENCHMARK_F(Median, Parallel, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel(input_data, output_data, data_size);
+}
+
+#if 0
+BENCHMARK_F(Median, ParallelAVX2, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_avx2(input_data, output_data, data_size);
+}
+#endif
+
+BENCHMARK_F(Median, ParallelStep1, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_step1(input_data, output_data, data_size);
+}
+
+BENCHMARK_F(Median, Stream4K, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Stream_packets<1024>(input_data, output_data, data_size);
+}
+
+BENCHMARK_F(Median, Memcpy, CounterFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	memcpy_Parallel(input_data, output_data, data_size);
+}
+
+BASELINE(MedianNan, Unchecked, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel<NanPolicy::Unchecked>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianNan, Propagate, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel<NanPolicy::Propagate>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianNan, Ignore, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel<NanPolicy::Ignore>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianNan, AsInfinity, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel<NanPolicy::AsInfinity>(input_data, output_data, data_size);
+}
+
+//- The boundary modes only change the 3 outputs at either end, so all of them should match
+//  Replicate; Valid writes 6 fewer.
+//
+BASELINE(MedianBoundary, Replicate, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel<BoundaryMode::Replicate>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianBoundary, Reflect, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel<BoundaryMode::Reflect>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianBoundary, Mirror, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel<BoundaryMode::Mirror>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianBoundary, Wrap, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel<BoundaryMode::Wrap>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianBoundary, Constant, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel<BoundaryMode::Constant>(input_data, output_data, data_size, 0.0f);
+}
+
+BENCHMARK(MedianBoundary, Valid, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel<BoundaryMode::Valid>(input_data, output_data, data_size);
+}
+
+//- 1 GB input and output buffers, shared by the benchmark groups that stream from DRAM and only
+//  allocated once one of them runs.
+//
+static constexpr size_t dram_size = size_t(1) << 28;
+
+static float* dram_input()
+{
+	static float* const data = []
+	{
+		float* data = alloc(dram_size);
+		for (size_t i = 0; i < dram_size; ++i)
+			data[i] = input_data[i % data_size];
+		return data;
+	}();
+	return data;
+}
+
+static float* dram_output()
+{
+	static float* const data = []
+	{
+		float* data = alloc(dram_size);
+		std::fill_n(data, dram_size, 0.0f);
+		return data;
+	}();
+	return data;
+}
+
+//- The Median group on DRAM-resident input. The problem space is the number of input bytes, so
+//  Celero's throughput column reads as bytes/s of input (and as many of output).
+//
+class DramFixture : public celero::TestFixture
+{
+public:
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { { int64_t(1) << 28, 4 }, { int64_t(1) << 30, 1 } };
+	}
+
+	void setUp(const celero::TestFixture::ExperimentValue& experimentValue) override
+	{
+		psrc = dram_input();
+		pdst = dram_output();
+		size = (size_t)experimentValue.Value / sizeof(float);
+	}
+
+	const float* psrc = nullptr;
+	float* pdst = nullptr;
+	size_t size = 0;
+};
+
+BASELINE_F(MedianDRAM, Memcpy, DramFixture, 10, 1)
+{
+	memcpy_Parallel(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianDRAM, ParallelStep1, DramFixture, 10, 1)
+{
+	median_Parallel_step1(psrc, pdst, size, false);
+}
+
+BENCHMARK_F(MedianDRAM, Aligned, DramFixture, 10, 1)
+{
+	median_Parallel_step1_aligned(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianDRAM, AlignedNoPrefetch, DramFixture, 10, 1)
+{
+	median_Parallel_step1_aligned(psrc, pdst, size, 0);
+}
+
+BENCHMARK_F(MedianDRAM, AlignedPrefetch256, DramFixture, 10, 1)
+{
+	median_Parallel_step1_aligned(psrc, pdst, size, 256);
+}
+
+BENCHMARK_F(MedianDRAM, AlignedPrefetch4K, DramFixture, 10, 1)
+{
+	median_Parallel_step1_aligned(psrc, pdst, size, 4096);
+}
+
+BASELINE(Dispatch, Median7, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median7(input_data, output_data, data_size);
+}
+
+BASELINE(MedianFilter, Parallel, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianFilter, Window3, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_filter<1>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianFilter, Window5, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_filter<2>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianFilter, Window7, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_filter<3>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianFilter, Window9, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_filter<4>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianFilter, Window11, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_filter<5>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianFilter, Window15, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_filter<7>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianFilter, Window25, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_filter<12>(input_data, output_data, data_size);
+}
+
+BENCHMARK(MedianFilter, Cpp9, 1, 1)
+{
+	median_Cpp(input_data, output_data, data_size, 9);
+}
+
+//- Rolling rank statistics for envelope detection: single ranks of 7 and 15 taps, and the
+//  minimum, 10th percentile, median, 90th percentile and maximum of 15 taps from one shared pass
+//  against five separate passes.
+//
+static float* const* rank_outputs()
+{
+	static float* const outputs[] = { alloc(data_size), alloc(data_size), alloc(data_size), alloc(data_size), alloc(data_size) };
+	return outputs;
+}
+
+BASELINE(RankFilter, ParallelStep1, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_step1(input_data, output_data, data_size);
+}
+
+BENCHMARK(RankFilter, Median7, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	rank_filter<7, 3>(input_data, output_data, data_size);
+}
+
+BENCHMARK(RankFilter, Min15, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	rank_filter<15, 0>(input_data, output_data, data_size);
+}
+
+BENCHMARK(RankFilter, Percentile15, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	rank_filter<15, 1>(input_data, output_data, data_size);
+}
+
+BENCHMARK(RankFilter, Median15, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	rank_filter<15, 7>(input_data, output_data, data_size);
+}
+
+BENCHMARK(RankFilter, Envelope15, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	rank_filter<15, 0, 1, 7, 13, 14>(input_data, rank_outputs(), data_size);
+}
+
+BENCHMARK(RankFilter, Envelope15Separate, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	float* const* outputs = rank_outputs();
+	rank_filter<15, 0>(input_data, outputs[0], data_size);
+	rank_filter<15, 1>(input_data, outputs[1], data_size);
+	rank_filter<15, 7>(input_data, outputs[2], data_size);
+	rank_filter<15, 13>(input_data, outputs[3], data_size);
+	rank_filter<15, 14>(input_data, outputs[4], data_size);
+}
+
+//- Weighted medians of the 7-tap window: all weights 1 is the plain median through the
+//  expanded network, the others widen it to 9, 11 and 13 copies of the taps.
+//
+BASELINE(WeightedMedian, Parallel, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel(input_data, output_data, data_size);
+}
+
+BENCHMARK(WeightedMedian, Median7, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	weighted_median<1, 1, 1, 1, 1, 1, 1>(input_data, output_data, data_size);
+}
+
+BENCHMARK(WeightedMedian, CenterWeighted3, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	center_weighted_median<3>(input_data, output_data, data_size);
+}
+
+BENCHMARK(WeightedMedian, CenterWeighted5, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	center_weighted_median<5>(input_data, output_data, data_size);
+}
+
+BENCHMARK(WeightedMedian, Weighted, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	weighted_median<1, 2, 2, 3, 2, 2, 1>(input_data, output_data, data_size);
+}
+
+BENCHMARK(WeightedMedian, Cpp, 1, 1)
+{
+	weighted_Cpp_filter<1, 2, 2, 3, 2, 2, 1>(input_data, output_data, data_size);
+}
+
+class WindowFixture : public celero::TestFixture
+{
+public:
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { 31, 63, 127, 255, 511, 1023, 2047, 4095 };
+	}
+
+	void setUp(const celero::TestFixture::ExperimentValue& experimentValue) override
+	{
+		window = (size_t)experimentValue.Value;
+	}
+
+	size_t window = 0;
+};
+
+BASELINE_F(RunningMedian, Cpp, WindowFixture, 1, 1)
+{
+	median_Cpp(input_data, output_data, data_size, window);
+}
+
+BENCHMARK_F(RunningMedian, Running, WindowFixture, BENCH_SAMPLES, 10)
+{
+	median_Running(input_data, output_data, data_size, window);
+}
+
+//- Spike removal: the scalar Hampel filter, the fused kernel with and without the outlier
+//  bitmask, and median_Parallel_step1 alone as the lower bound.
+//
+BASELINE(Hampel, Cpp, 1, 1)
+{
+	hampel_Cpp(spiky_input().data(), output_data, data_size, hampel_threshold);
+}
+
+BENCHMARK(Hampel, Fused, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	hampel_filter(spiky_input().data(), output_data, data_size, hampel_threshold);
+}
+
+BENCHMARK(Hampel, FusedBitmask, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	static std::vector<uint8_t> outliers((data_size + 7) / 8);
+	hampel_filter(spiky_input().data(), output_data, data_size, hampel_threshold, outliers.data());
+}
+
+BENCHMARK(Hampel, MedianOnly, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_step1(spiky_input().data(), output_data, data_size);
+}
+
+//- Rolling minimum and maximum, opening and closing, at a cost that should not depend on the
+//  window; the baseline is the sort-based emulation through rank_Cpp. OpeningSeparate is the
+//  unfused erosion and dilation, each over the whole input.
+//
+class MorphologyFixture : public WindowFixture
+{
+public:
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { 3, 7, 15, 31, 63, 127, 255, 501, 1001 };
+	}
+};
+
+BASELINE_F(Morphology, Cpp, MorphologyFixture, 1, 1)
+{
+	rank_Cpp(input_data, output_data, data_size, window, 0);
+}
+
+BENCHMARK_F(Morphology, Min, MorphologyFixture, BENCH_SAMPLES, 100)
+{
+	min_filter(input_data, output_data, data_size, window);
+}
+
+BENCHMARK_F(Morphology, Max, MorphologyFixture, BENCH_SAMPLES, 100)
+{
+	max_filter(input_data, output_data, data_size, window);
+}
+
+BENCHMARK_F(Morphology, Opening, MorphologyFixture, BENCH_SAMPLES, 100)
+{
+	opening_filter(input_data, output_data, data_size, window);
+}
+
+BENCHMARK_F(Morphology, OpeningSeparate, MorphologyFixture, BENCH_SAMPLES, 100)
+{
+	static float* const eroded = alloc(data_size);
+	min_filter(input_data, eroded, data_size, window);
+	max_filter(eroded, output_data, data_size, window);
+}
+
+BENCHMARK_F(Morphology, Closing, MorphologyFixture, BENCH_SAMPLES, 100)
+{
+	closing_filter(input_data, output_data, data_size, window);
+}
+
+class ThreadScalingFixture : public celero::TestFixture
+{
+public:
+	//- From L2-resident (128 KB) up to DRAM-resident (256 MB) inputs.
+	//
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { { 1 << 15, 4096 }, { 1 << 18, 512 }, { 1 << 21, 64 }, { 1 << 24, 8 }, { 1 << 26, 2 } };
+	}
+
+	void setUp(const celero::TestFixture::ExperimentValue& experimentValue) override
+	{
+		static float* const src = make_input(1 << 26);
+		static float* const dst = alloc(1 << 26);
+
+		psrc = src;
+		pdst = dst;
+		size = (size_t)experimentValue.Value;
+	}
+
+	static float* make_input(size_t size)
+	{
+		float* data = alloc(size);
+		for (size_t i = 0; i < size; ++i)
+			data[i] = input_data[i % data_size];
+		return data;
+	}
+
+	const float* psrc = nullptr;
+	float* pdst = nullptr;
+	size_t size = 0;
+};
+
+BASELINE_F(MedianThreads, Parallel, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	median_Parallel(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianThreads, Threads1, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	median_Parallel_mt(psrc, pdst, size, 1);
+}
+
+BENCHMARK_F(MedianThreads, Threads2, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	median_Parallel_mt(psrc, pdst, size, 2);
+}
+
+BENCHMARK_F(MedianThreads, Threads4, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	median_Parallel_mt(psrc, pdst, size, 4);
+}
+
+BENCHMARK_F(MedianThreads, Threads8, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	median_Parallel_mt(psrc, pdst, size, 8);
+}
+
+BENCHMARK_F(MedianThreads, Threads16, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	median_Parallel_mt(psrc, pdst, size, 16);
+}
+
+BENCHMARK_F(MedianThreads, Threads32, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	median_Parallel_mt(psrc, pdst, size, 32);
+}
+
+BENCHMARK_F(MedianThreads, ThreadsAll, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	median_Parallel_mt(psrc, pdst, size, 0);
+}
+
+//- 3 and 5 passes of the median as separate calls, each a round trip through memory once the
+//  signal leaves the cache, against the passes fused per tile; Root runs to convergence.
+//
+BASELINE_F(IteratedMedian, Separate3, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	median_Parallel(psrc, pdst, size);
+	median_Parallel(pdst, pdst, size);
+	median_Parallel(pdst, pdst, size);
+}
+
+BENCHMARK_F(IteratedMedian, Fused3, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	iterated_median(psrc, pdst, size, 3);
+}
+
+BENCHMARK_F(IteratedMedian, Separate5, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	median_Parallel(psrc, pdst, size);
+	for (int pass = 1; pass < 5; ++pass)
+		median_Parallel(pdst, pdst, size);
+}
+
+BENCHMARK_F(IteratedMedian, Fused5, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	iterated_median(psrc, pdst, size, 5);
+}
+
+BENCHMARK_F(IteratedMedian, Root, ThreadScalingFixture, BENCH_SAMPLES, 1)
+{
+	iterated_median_root(psrc, pdst, size, root_max_passes);
+}
+
+//- Cached against non-temporal stores from L2-resident (512 KB) to DRAM-resident (1 GB) outputs,
+//  with the store loop as the bandwidth bound. Celero's throughput column reads as samples/s.
+//
+class StreamingFixture : public celero::TestFixture
+{
+public:
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { { 1 << 17, 1024 }, { 1 << 20, 128 }, { 1 << 23, 16 }, { 1 << 26, 2 }, { 1 << 28, 1 } };
+	}
+
+	void setUp(const celero::TestFixture::ExperimentValue& experimentValue) override
+	{
+		psrc = dram_input();
+		pdst = dram_output();
+		size = (size_t)experimentValue.Value;
+	}
+
+	const float* psrc = nullptr;
+	float* pdst = nullptr;
+	size_t size = 0;
+};
+
+BASELINE_F(MedianStreaming, Memcpy, StreamingFixture, 10, 1)
+{
+	memcpy_Parallel(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianStreaming, Cached, StreamingFixture, 10, 1)
+{
+	median_Parallel(psrc, pdst, size, false);
+}
+
+BENCHMARK_F(MedianStreaming, Streaming, StreamingFixture, 10, 1)
+{
+	median_Parallel(psrc, pdst, size, true);
+}
+
+BENCHMARK_F(MedianStreaming, Step1Cached, StreamingFixture, 10, 1)
+{
+	median_Parallel_step1(psrc, pdst, size, false);
+}
+
+BENCHMARK_F(MedianStreaming, Step1Streaming, StreamingFixture, 10, 1)
+{
+	median_Parallel_step1(psrc, pdst, size, true);
+}
+
+//- The same kernel on input and output that start 4 bytes past a cache line (so that every 64-byte
+//  load and store is split), on 64-byte aligned buffers from a SampleArena, and on an arena backed
+//  by 2 MB pages; from L2-resident (128 KB) to DRAM-resident (128 MB) inputs.
+//
+enum class BufferLayout
+{
+	Misaligned,
+	Aligned,
+	HugePages,
+};
+
+template<BufferLayout Layout>
+class LayoutFixture : public celero::TestFixture
+{
+public:
+	static constexpr size_t max_size = size_t(1) << 25;
+
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { { 1 << 15, 4096 }, { 1 << 20, 128 }, { int64_t(max_size), 4 } };
+	}
+
+	void setUp(const celero::TestFixture::ExperimentValue& experimentValue) override
+	{
+		static SampleArena arena(2 * (max_size + 16) * sizeof(float), Layout == BufferLayout::HugePages);
+		static float* const src = make_buffer(arena);
+		static float* const dst = make_buffer(arena);
+
+		psrc = src;
+		pdst = dst;
+		size = (size_t)experimentValue.Value;
+	}
+
+	static float* make_buffer(SampleArena& arena)
+	{
+		float* data = arena.allocate<float>(max_size + 16) + (Layout == BufferLayout::Misaligned ? 1 : 0);
+		for (size_t i = 0; i < max_size; ++i)
+			data[i] = input_data[i % data_size];
+		return data;
+	}
+
+	const float* psrc = nullptr;
+	float* pdst = nullptr;
+	size_t size = 0;
+};
+
+BASELINE_F(MedianLayout, Misaligned, LayoutFixture<BufferLayout::Misaligned>, 10, 1)
+{
+	median_Parallel(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianLayout, Aligned, LayoutFixture<BufferLayout::Aligned>, 10, 1)
+{
+	median_Parallel(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianLayout, HugePages, LayoutFixture<BufferLayout::HugePages>, 10, 1)
+{
+	median_Parallel(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianLayout, Step1Misaligned, LayoutFixture<BufferLayout::Misaligned>, 10, 1)
+{
+	median_Parallel_step1(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianLayout, Step1Aligned, LayoutFixture<BufferLayout::Aligned>, 10, 1)
+{
+	median_Parallel_step1(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianLayout, Step1HugePages, LayoutFixture<BufferLayout::HugePages>, 10, 1)
+{
+	median_Parallel_step1(psrc, pdst, size);
+}
+
+//- Every SIMD float kernel, against memcpy as the bandwidth bound, from 16 samples to 2^28 (1 GB):
+//  reading from each misalignment of 0 .. 15 floats past a 64-byte boundary into an aligned
+//  destination, and from an aligned source into each destination misalignment. The sizes just
+//  past a multiple of 16 show the cost of the tail handling; the large ones the cache level cliffs.
+//
+//  Celero's problem space is a single number, so each experiment value packs the parameters as
+//  size * 10000 + source offset * 100 + destination offset: 6553600307 is 65536 samples read from
+//  offset 3 and written to offset 7. The user defined measurement is samples/ns, which compares
+//  across sizes; write the table with -t to track it across releases.
+//
+static constexpr int64_t sweep_packing = 10000;
+
+class SamplesPerNsMeasurement : public celero::UserDefinedMeasurementTemplate<double>
+{
+public:
+	std::string getName() const override
+	{
+		return "samples/ns";
+	}
+};
+
+class SweepFixture : public celero::TestFixture
+{
+public:
+	static constexpr size_t max_size = size_t(1) << 28;
+
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		static const int64_t sizes[] = { 16, 23, 64, 71, 256, 263, 1 << 10, 1 << 12, 1 << 14, 1 << 16,
+			1 << 18, 1 << 20, 1 << 22, 1 << 24, 1 << 26, 1 << 28 };
+
+		std::vector<celero::TestFixture::ExperimentValue> values;
+		for (int64_t size : sizes)
+		{
+			// About 4M samples per measurement, so that every size takes a comparable time
+			int64_t const iterations = std::max<int64_t>(1, (1 << 22) / size);
+			for (int64_t offset = 0; offset < 16; ++offset)
+				values.push_back({ size * sweep_packing + offset * 100, iterations });
+			for (int64_t offset = 1; offset < 16; ++offset)
+				values.push_back({ size * sweep_packing + offset, iterations });
+		}
+		return values;
+	}
+
+	void setUp(const celero::TestFixture::ExperimentValue& experimentValue) override
+	{
+		static SampleArena arena(2 * (max_size + 16) * sizeof(float));
+		static float* const src = make_buffer(arena);
+		static float* const dst = make_buffer(arena);
+
+		size = (size_t)(experimentValue.Value / sweep_packing);
+		psrc = src + (experimentValue.Value % sweep_packing) / 100;
+		pdst = dst + experimentValue.Value % 100;
+		samples = (double)size * (double)experimentValue.Iterations;
+		start = std::chrono::steady_clock::now();
+	}
+
+	void tearDown() override
+	{
+		std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now() - start;
+		rate->addValue(samples / elapsed.count());
+	}
+
+	std::vector<std::shared_ptr<celero::UserDefinedMeasurement>> getUserDefinedMeasurements() const override
+	{
+		return { rate };
+	}
+
+	static float* make_buffer(SampleArena& arena)
+	{
+		float* data = arena.allocate<float>(max_size + 16);
+		for (size_t i = 0; i < max_size + 16; ++i)
+			data[i] = input_data[i % data_size];
+		return data;
+	}
+
+	std::shared_ptr<SamplesPerNsMeasurement> rate = std::make_shared<SamplesPerNsMeasurement>();
+	const float* psrc = nullptr;
+	float* pdst = nullptr;
+	size_t size = 0;
+	double samples = 0.0;
+	std::chrono::steady_clock::time_point start;
+};
+
+BASELINE_F(MedianSweep, Memcpy, SweepFixture, 5, 1)
+{
+	memcpy_Parallel(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianSweep, Step0, SweepFixture, 5, 1)
+{
+	median_Step0(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianSweep, Step1, SweepFixture, 5, 1)
+{
+	median_Step1(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianSweep, Step2, SweepFixture, 5, 1)
+{
+	median_Step2(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianSweep, Step3, SweepFixture, 5, 1)
+{
+	median_Step3(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianSweep, Parallel, SweepFixture, 5, 1)
+{
+	median_Parallel(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianSweep, ParallelAVX2, SweepFixture, 5, 1)
+{
+	median_Parallel_avx2(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianSweep, ParallelStep1, SweepFixture, 5, 1)
+{
+	median_Parallel_step1(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianSweep, Step1Aligned, SweepFixture, 5, 1)
+{
+	median_Parallel_step1_aligned(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianSweep, Stream4K, SweepFixture, 5, 1)
+{
+	median_Stream_packets<1024>(psrc, pdst, size);
+}
+
+BENCHMARK_F(MedianSweep, ThreadsAll, SweepFixture, 5, 1)
+{
+	median_Parallel_mt(psrc, pdst, size, 0);
+}
+
+//- A 256 MB capture filtered by all threads, into a second buffer or in place. The user defined
+//  measurement is the growth of the resident set over a sample, in MB (only measured on Linux).
+//
+static int64_t resident_bytes()
+{
+#ifdef __linux__
+	std::ifstream statm("/proc/self/statm");
+	int64_t pages = 0, resident = 0;
+	statm >> pages >> resident;
+	return resident * sysconf(_SC_PAGESIZE);
+#else
+	return 0;
+#endif
+}
+
+class ResidentMeasurement : public celero::UserDefinedMeasurementTemplate<int64_t>
+{
+public:
+	std::string getName() const override
+	{
+		return "RSS MB";
+	}
+};
+
+template<bool InPlace>
+class CaptureFixture : public celero::TestFixture
+{
+public:
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { 1 << 26 };
+	}
+
+	void setUp(const celero::TestFixture::ExperimentValue& experimentValue) override
+	{
+		size = (size_t)experimentValue.Value;
+		resident = resident_bytes();
+		psrc = alloc(size);
+		pdst = InPlace ? psrc : alloc(size);
+		for (size_t i = 0; i < size; ++i)
+			psrc[i] = input_data[i % data_size];
+		if (!InPlace)
+			std::fill_n(pdst, size, 0.0f);
+	}
+
+	void tearDown() override
+	{
+		rss->addValue((resident_bytes() - resident) >> 20);
+		if (!InPlace)
+			::operator delete[](pdst, std::align_val_t{ SampleArena::alignment });
+		::operator delete[](psrc, std::align_val_t{ SampleArena::alignment });
+	}
+
+	std::vector<std::shared_ptr<celero::UserDefinedMeasurement>> getUserDefinedMeasurements() const override
+	{
+		return { rss };
+	}
+
+	std::shared_ptr<ResidentMeasurement> rss = std::make_shared<ResidentMeasurement>();
+	float* psrc = nullptr;
+	float* pdst = nullptr;
+	size_t size = 0;
+	int64_t resident = 0;
+};
+
+BASELINE_F(MedianInPlace, Separate, CaptureFixture<false>, 10, 1)
+{
+	median_Parallel_mt(psrc, pdst, size, 0);
+}
+
+BENCHMARK_F(MedianInPlace, InPlace, CaptureFixture<true>, 10, 1)
+{
+	median_Parallel_mt(psrc, psrc, size, 0);
+}
+
+//- A 4K frame, against the row by row 1D filter it replaces. Celero's throughput column reads
+//  as pixels/s.
+//
+class FrameFixture : public celero::TestFixture
+{
+public:
+	static constexpr size_t width = 3840;
+	static constexpr size_t height = 2160;
+
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { (int64_t)(width * height) };
+	}
+
+	void setUp(const celero::TestFixture::ExperimentValue&) override
+	{
+		static float* const src = ThreadScalingFixture::make_input(width * height);
+		static float* const dst = alloc(width * height);
+
+		psrc = src;
+		pdst = dst;
+	}
+
+	const float* psrc = nullptr;
+	float* pdst = nullptr;
+};
+
+BASELINE_F(MedianFilter2D, Rows7, FrameFixture, BENCH_SAMPLES, 10)
+{
+	for (size_t y = 0; y < height; ++y)
+		median_Parallel(psrc + y * width, pdst + y * width, width);
+}
+
+BENCHMARK_F(MedianFilter2D, Square3, FrameFixture, BENCH_SAMPLES, 10)
+{
+	median_filter_2d<1>(psrc, width, pdst, width, width, height);
+}
+
+BENCHMARK_F(MedianFilter2D, Square5, FrameFixture, BENCH_SAMPLES, 10)
+{
+	median_filter_2d<2>(psrc, width, pdst, width, width, height);
+}
+
+BENCHMARK_F(MedianFilter2D, Square7, FrameFixture, BENCH_SAMPLES, 10)
+{
+	median_filter_2d<3>(psrc, width, pdst, width, width, height);
+}
+
+BENCHMARK_F(MedianFilter2D, Cpp3, FrameFixture, 1, 1)
+{
+	median_Cpp_2d(psrc, width, pdst, width, width, height, 3);
+}
+
+//- Interleaved channels, against de-interleaving each channel into scratch buffers and back.
+//
+static void median_Scratch_stereo(const float* psrc, float* pdst, size_t frames)
+{
+	static std::vector<float> channel(data_size);
+	static std::vector<float> filtered(data_size);
+	for (size_t c = 0; c < 2; ++c)
+	{
+		for (size_t i = 0; i < frames; ++i)
+			channel[i] = psrc[i * 2 + c];
+		median_Parallel(channel.data(), filtered.data(), frames);
+		for (size_t i = 0; i < frames; ++i)
+			pdst[i * 2 + c] = filtered[i];
+	}
+}
+
+BASELINE(MedianInterleaved, ScratchStereo, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Scratch_stereo(input_data, output_data, data_size / 2);
+}
+
+BENCHMARK(MedianInterleaved, Stereo, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_interleaved(input_data, output_data, data_size / 2, 2);
+}
+
+BENCHMARK(MedianInterleaved, RGB, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_interleaved(input_data, output_data, data_size / 3, 3);
+}
+
+BENCHMARK(MedianInterleaved, RGBA, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_interleaved(input_data, output_data, data_size / 4, 4);
+}
+
+BENCHMARK(MedianInterleaved, Gather5, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_interleaved(input_data, output_data, data_size / 5, 5);
+}
+
+//- The whole input cut into series of 8 .. 256 samples, against one median_Parallel call per
+//  series.
+//
+class SeriesFixture : public celero::TestFixture
+{
+public:
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { 8, 16, 32, 48, 64, 80, 128, 256 };
+	}
+
+	void setUp(const celero::TestFixture::ExperimentValue& experimentValue) override
+	{
+		len = (size_t)experimentValue.Value;
+		count = data_size / len;
+		srcs.resize(count);
+		dsts.resize(count);
+		lens.assign(count, len);
+		for (size_t i = 0; i < count; ++i)
+		{
+			srcs[i] = input_data + i * len;
+			dsts[i] = output_data + i * len;
+		}
+	}
+
+	std::vector<const float*> srcs;
+	std::vector<float*> dsts;
+	std::vector<size_t> lens;
+	size_t len = 0;
+	size_t count = 0;
+};
+
+BASELINE_F(MedianBatch, Loop, SeriesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	for (size_t i = 0; i < count; ++i)
+		median_Parallel(srcs[i], dsts[i], len);
+}
+
+BENCHMARK_F(MedianBatch, Batch, SeriesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_batch(srcs.data(), dsts.data(), lens.data(), count);
+}
+
+BENCHMARK_F(MedianBatch, Rows, SeriesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_rows(input_data, len, output_data, len, len, count);
+}
+
+//- The problem space is the number of samples per call, so Celero's throughput column reads
+//  as samples/s.
+//
+class SamplesFixture : public celero::TestFixture
+{
+public:
+	std::vector<celero::TestFixture::ExperimentValue> getExperimentValues() const override
+	{
+		return { (int64_t)data_size };
+	}
+};
+
+BASELINE_F(MedianTyped, Float, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel(input_data, output_data, data_size);
+}
+
+BENCHMARK_F(MedianTyped, U8, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel(typed_input<uint8_t>().data(), typed_output<uint8_t>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, I16, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel(typed_input<int16_t>().data(), typed_output<int16_t>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, U16, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel(typed_input<uint16_t>().data(), typed_output<uint16_t>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, I32, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel(typed_input<int32_t>().data(), typed_output<int32_t>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, F64, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel(typed_input<double>().data(), typed_output<double>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, F64Step1, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_step1(typed_input<double>().data(), typed_output<double>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, FloatAVX2, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_avx2(input_data, output_data, data_size);
+}
+
+BENCHMARK_F(MedianTyped, U8AVX2, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_avx2(typed_input<uint8_t>().data(), typed_output<uint8_t>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, I16AVX2, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_avx2(typed_input<int16_t>().data(), typed_output<int16_t>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, U16AVX2, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_avx2(typed_input<uint16_t>().data(), typed_output<uint16_t>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, I32AVX2, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_avx2(typed_input<int32_t>().data(), typed_output<int32_t>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, F64AVX2, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_avx2(typed_input<double>().data(), typed_output<double>().data(), data_size);
+}
+
+BENCHMARK_F(MedianTyped, F64Step1AVX2, SamplesFixture, BENCH_SAMPLES, BENCH_ITERATIONS)
+{
+	median_Parallel_step1_avx2(typed_input<double>().data(), typed_output<double>().data(), data_size);
+}
@@ -1,287 +1,719 @@
-﻿#pragma once
-
-#include <cstdint>
-#include <immintrin.h>
-
-void median_Cpp(const float*, float*, size_t);
-void median_Step0(const float*, float*, size_t);
-void median_Step1(const float*, float*, size_t);
-void median_Step2(const float*, float*, size_t);
-void median_Step3(const float*, float*, size_t);
-void median_Parallel(const float*, float*, size_t);
-void median_Parallel_avx2(const float*, float*, size_t);
-void median_Parallel_step1(const float*, float*, size_t);
-
-#ifdef _MSC_VER
-#define KEWB_FORCE_INLINE __forceinline
-#else
-#define KEWB_FORCE_INLINE __attribute__((__always_inline__)) inline
-#endif
-
-using rf512 = __m512;
-using ri512 = __m512i;
-using r512f = __m512;
-
-using m512 = uint32_t;
-
-void dump_reg(const char* const name, rf512 value);
-void dump_reg(const char* const name, ri512 value);
-#define DUMP_REG(r) dump_reg(#r, r)
-
-KEWB_FORCE_INLINE r512f
-    load_from(float const* psrc)
-{
-    return _mm512_loadu_ps(psrc);
-}
-
-KEWB_FORCE_INLINE r512f
-    masked_load_from(float const* psrc, r512f fill, m512 mask)
-{
-    return _mm512_mask_loadu_ps(fill, (__mmask16)mask, psrc);
-}
-
-KEWB_FORCE_INLINE __m512
-    load_value(float v)
-{
-    return _mm512_set1_ps(v);
-}
-
-KEWB_FORCE_INLINE void
-    store_to_address(void* pdst, rf512 r)
-{
-    _mm512_mask_storeu_ps(pdst, (__mmask16)0xFFFFu, r);
-}
-
-KEWB_FORCE_INLINE void
-store_to_address(void* pdst, ri512 r)
-{
-    _mm512_mask_storeu_epi32(pdst, (__mmask16)0xFFFFu, r);
-}
-
-KEWB_FORCE_INLINE void
-    masked_store_to(void* pdst, __m512 r, m512 mask)
-{
-    _mm512_mask_storeu_ps(pdst, (__mmask16)mask, r);
-}
-
-template<int A, int B, int C, int D, int E, int F, int G, int H,
-    int I, int J, int K, int L, int M, int N, int O, int P>
-    KEWB_FORCE_INLINE __m512i
-    load_values()
-{
-    return _mm512_setr_epi32(A, B, C, D, E, F, G, H, I, J, K, L, M, N, O, P);
-}
-
-KEWB_FORCE_INLINE __m512
-    blend(__m512 r0, __m512 r1, uint32_t mask)
-{
-    return _mm512_mask_blend_ps((__mmask16)mask, r0, r1);
-}
-
-KEWB_FORCE_INLINE __m512
-    permute(__m512 r, __m512i perm)
-{
-    return _mm512_permutexvar_ps(perm, r);
-}
-
-template<int BIAS, uint32_t MASK>
-KEWB_FORCE_INLINE __m512i
-    make_shift_permutation()
-{
-    constexpr int32_t   a = ((BIAS + 0) % 16) | ((MASK & 1u) ? 0x10 : 0);
-    constexpr int32_t   b = ((BIAS + 1) % 16) | ((MASK & 1u << 1u) ? 0x10 : 0);
-    constexpr int32_t   c = ((BIAS + 2) % 16) | ((MASK & 1u << 2u) ? 0x10 : 0);
-    constexpr int32_t   d = ((BIAS + 3) % 16) | ((MASK & 1u << 3u) ? 0x10 : 0);
-    constexpr int32_t   e = ((BIAS + 4) % 16) | ((MASK & 1u << 4u) ? 0x10 : 0);
-    constexpr int32_t   f = ((BIAS + 5) % 16) | ((MASK & 1u << 5u) ? 0x10 : 0);
-    constexpr int32_t   g = ((BIAS + 6) % 16) | ((MASK & 1u << 6u) ? 0x10 : 0);
-    constexpr int32_t   h = ((BIAS + 7) % 16) | ((MASK & 1u << 7u) ? 0x10 : 0);
-    constexpr int32_t   i = ((BIAS + 8) % 16) | ((MASK & 1u << 8u) ? 0x10 : 0);
-    constexpr int32_t   j = ((BIAS + 9) % 16) | ((MASK & 1u << 9u) ? 0x10 : 0);
-    constexpr int32_t   k = ((BIAS + 10) % 16) | ((MASK & 1u << 10u) ? 0x10 : 0);
-    constexpr int32_t   l = ((BIAS + 11) % 16) | ((MASK & 1u << 11u) ? 0x10 : 0);
-    constexpr int32_t   m = ((BIAS + 12) % 16) | ((MASK & 1u << 12u) ? 0x10 : 0);
-    constexpr int32_t   n = ((BIAS + 13) % 16) | ((MASK & 1u << 13u) ? 0x10 : 0);
-    constexpr int32_t   o = ((BIAS + 14) % 16) | ((MASK & 1u << 14u) ? 0x10 : 0);
-    constexpr int32_t   p = ((BIAS + 15) % 16) | ((MASK & 1u << 15u) ? 0x10 : 0);
-
-    return _mm512_setr_epi32(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);
-}
-
-template<int R>
-KEWB_FORCE_INLINE __m512
-    rotate(__m512 r0)
-{
-    if constexpr ((R % 16) == 0)
-    {
-        return r0;
-    }
-    else
-    {
-        constexpr int    S = (R > 0) ? (16 - (R % 16)) : -R;
-        constexpr int    A = (S + 0) % 16;
-        constexpr int    B = (S + 1) % 16;
-        constexpr int    C = (S + 2) % 16;
-        constexpr int    D = (S + 3) % 16;
-        constexpr int    E = (S + 4) % 16;
-        constexpr int    F = (S + 5) % 16;
-        constexpr int    G = (S + 6) % 16;
-        constexpr int    H = (S + 7) % 16;
-        constexpr int    I = (S + 8) % 16;
-        constexpr int    J = (S + 9) % 16;
-        constexpr int    K = (S + 10) % 16;
-        constexpr int    L = (S + 11) % 16;
-        constexpr int    M = (S + 12) % 16;
-        constexpr int    N = (S + 13) % 16;
-        constexpr int    O = (S + 14) % 16;
-        constexpr int    P = (S + 15) % 16;
-
-        return _mm512_permutexvar_ps(_mm512_setr_epi32(A, B, C, D, E, F, G, H, I, J, K, L, M, N, O, P), r0);
-    }
-}
-
-template<int R>
-KEWB_FORCE_INLINE __m512
-    rotate_up(__m512 r0)
-{
-    static_assert(R >= 0);
-    return rotate<R>(r0);
-}
-
-template<int S>
-KEWB_FORCE_INLINE void
-    in_place_shift_down_with_carry(__m512& lo, __m512& hi)
-{
-    static_assert(S >= 0 && S <= 16);
-
-    constexpr uint32_t  zmask = (0xFFFFu >> (unsigned)S);
-    constexpr uint32_t  bmask = ~zmask & 0xFFFFu;
-    __m512i             perm = make_shift_permutation<S, bmask>();
-
-    lo = _mm512_permutex2var_ps(lo, perm, hi);
-    hi = _mm512_maskz_permutex2var_ps((__mmask16)zmask, hi, perm, hi);
-}
-
-
-template<int S>
-KEWB_FORCE_INLINE constexpr uint32_t
-    shift_up_blend_mask()
-{
-    static_assert(S >= 0 && S <= 16);
-    return (0xFFFFu << (unsigned)S) & 0xFFFFu;
-}
-
-template<int S>
-KEWB_FORCE_INLINE __m512
-    shift_up_with_carry(__m512 lo, __m512 hi)
-{
-    return blend(rotate_up<S>(lo), rotate_up<S>(hi), shift_up_blend_mask<S>());
-}
-
-KEWB_FORCE_INLINE __m512
-    mask_permute(__m512 r0, __m512 r1, __m512i perm, uint32_t mask)
-{
-    return _mm512_mask_permutexvar_ps(r0, (__mmask16)mask, perm, r1);
-}
-
-KEWB_FORCE_INLINE __m512
-    minimum(__m512 r0, __m512 r1)
-{
-    return _mm512_min_ps(r0, r1);
-}
-
-__m512
-    KEWB_FORCE_INLINE maximum(__m512 r0, __m512 r1)
-{
-    return _mm512_max_ps(r0, r1);
-}
-
-KEWB_FORCE_INLINE __m512
-mask_minimum(__m512 old, __m512 r0, __m512 r1, m512 mask)
-{
-    return _mm512_mask_min_ps(old, mask, r0, r1);
-}
-
-KEWB_FORCE_INLINE __m512
-mask_maximum(__m512 old, __m512 r0, __m512 r1, m512 mask)
-{
-    return _mm512_mask_max_ps(old, mask, r0, r1);
-}
-
-KEWB_FORCE_INLINE __m512
-    compare_with_exchange(__m512 vals, __m512i perm, m512 mask)
-{
-    __m512  exch = permute(vals, perm);
-    __m512  vmin = minimum(vals, exch);
-    __m512  vmax = maximum(vals, exch);
-
-    return blend(vmin, vmax, mask);
-}
-
-template<unsigned A = 0, unsigned B = 0, unsigned C = 0, unsigned D = 0,
-    unsigned E = 0, unsigned F = 0, unsigned G = 0, unsigned H = 0,
-    unsigned I = 0, unsigned J = 0, unsigned K = 0, unsigned L = 0,
-    unsigned M = 0, unsigned N = 0, unsigned O = 0, unsigned P = 0>
-    KEWB_FORCE_INLINE constexpr uint32_t
-    make_bitmask()
-{
-    static_assert((A < 2) && (B < 2) && (C < 2) && (D < 2) &&
-        (E < 2) && (F < 2) && (G < 2) && (H < 2) &&
-        (I < 2) && (J < 2) && (K < 2) && (L < 2) &&
-        (M < 2) && (N < 2) && (O < 2) && (P < 2));
-
-    return ((A << 0) | (B << 1) | (C << 2) | (D << 3) |
-        (E << 4) | (F << 5) | (G << 6) | (H << 7) |
-        (I << 8) | (J << 9) | (K << 10) | (L << 11) |
-        (M << 12) | (N << 13) | (O << 14) | (P << 15));
-}
-
-template<unsigned... IDXS>
-KEWB_FORCE_INLINE auto
-    make_permute()
-{
-    static_assert(sizeof...(IDXS) == 8 || sizeof...(IDXS) == 16);
-
-    if constexpr (sizeof...(IDXS) == 8)
-    {
-        return _mm256_setr_epi32(IDXS...);
-    }
-    else
-    {
-        return load_values<IDXS...>();
-    }
-}
-
-KEWB_FORCE_INLINE __m512
-    sort_two_lanes_of_7(rf512 vals)
-{
-    //- Precompute the permutations and bitmasks for the 6 stages of this bitonic sorting sequence.
-    //                                   0   1   2   3   4   5   6   7     0   1   2   3   4   5   6   7
-    //                                  ---------------------------------------------------
-    ri512 const     perm0 = make_permute<4, 5, 6, 3, 0, 1, 2, 7, 12, 13, 14, 11, 8, 9, 10, 15>();
-    constexpr m512  mask0 = make_bitmask<0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 1, 1, 1, 0>();
-
-    ri512 const     perm1 = make_permute<2, 3, 0, 1, 6, 5, 4, 7, 10, 11, 8, 9, 14, 13, 12, 15>();
-    constexpr m512  mask1 = make_bitmask<0, 0, 1, 1, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 1, 0>();
-
-    ri512 const     perm2 = make_permute<1, 0, 4, 5, 2, 3, 6, 7, 9, 8, 12, 13, 10, 11, 14, 15>();
-    constexpr m512  mask2 = make_bitmask<0, 1, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0>();
-
-    ri512 const     perm3 = make_permute<0, 1, 3, 2, 5, 4, 6, 7, 8, 9, 11, 10, 13, 12, 14, 15>();
-    constexpr m512  mask3 = make_bitmask<0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0>();
-
-    ri512 const     perm4 = make_permute<0, 4, 2, 6, 1, 5, 3, 7, 8, 12, 10, 14, 9, 13, 11, 15>();
-    constexpr m512  mask4 = make_bitmask<0, 0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0>();
-
-    ri512 const     perm5 = make_permute<0, 2, 1, 4, 3, 6, 5, 7, 8, 10, 9, 12, 11, 14, 13, 15>();
-    constexpr m512  mask5 = make_bitmask<0, 0, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 1, 0, 1, 0>();
-
-    vals = compare_with_exchange(vals, perm0, mask0);
-    vals = compare_with_exchange(vals, perm1, mask1);
-    vals = compare_with_exchange(vals, perm2, mask2);
-    vals = compare_with_exchange(vals, perm3, mask3);
-    vals = compare_with_exchange(vals, perm4, mask4);
-    vals = compare_with_exchange(vals, perm5, mask5);
-
-    return vals;
-}
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+//- median_Cpp, median_Parallel, median_Parallel_avx2, median_Parallel_step1, median_Parallel_mt
+//  and median7, as well as the integer and double median_Parallel kernels, may filter in place
+//  ('pdst' equal to 'psrc'); partially overlapping buffers are not supported.
+//
+void median_Cpp(const float*, float*, size_t);
+void median_Step0(const float*, float*, size_t);
+void median_Step1(const float*, float*, size_t);
+void median_Step2(const float*, float*, size_t);
+void median_Step3(const float*, float*, size_t);
+void median_Parallel(const float*, float*, size_t);
+void median_Parallel_avx2(const float*, float*, size_t);
+void median_Parallel_step1(const float*, float*, size_t);
+void median_Parallel_chunk(const float*, float*, size_t, bool lead_halo, bool trail_halo, bool streaming);
+void median_Parallel_mt(const float*, float*, size_t, size_t threads);
+void memcpy_Parallel(const float*, float*, size_t);
+
+//- Outputs of at least this many samples (64 MB, beyond the last level cache of most hosts) are
+//  written by median_Parallel, median_Parallel_step1 and median_Parallel_mt with non-temporal
+//  stores; the overloads taking 'streaming' force either kind of store.
+//
+constexpr size_t    median_streaming_threshold = size_t(1) << 24;
+
+void median_Parallel(const float*, float*, size_t, bool streaming);
+void median_Parallel_step1(const float*, float*, size_t, bool streaming);
+
+//- median_Parallel_step1 with its main loop on 64-byte aligned loads, for DRAM-resident input:
+//  the input is peeled back to the preceding 64-byte boundary and each iteration prefetches
+//  'prefetch_distance' samples ahead (median_prefetch_distance by default).
+//
+constexpr size_t    median_prefetch_distance = 1024;
+
+void median_Parallel_step1_aligned(const float*, float*, size_t);
+void median_Parallel_step1_aligned(const float*, float*, size_t, size_t prefetch_distance);
+
+//- Hampel outlier filter in one pass over median_Parallel_step1: sample i is replaced by the
+//  median of its 7-tap window when it lies more than 'threshold' times the scaled MAD (the median
+//  absolute deviation from that median, times hampel_mad_scale, which estimates the standard
+//  deviation of normal data) away from it. Edges are replicated. When 'outliers' is given, bit
+//  i % 8 of byte i / 8 is set for each replaced sample; (len + 7) / 8 bytes are written.
+//
+constexpr float     hampel_mad_scale = 1.4826f;
+
+void hampel_filter(const float*, float*, size_t, float threshold, uint8_t* outliers = nullptr);
+void hampel_Cpp(const float*, float*, size_t, float threshold, uint8_t* outliers = nullptr);
+
+//- The 7-tap median applied 'passes' times, as many calls to median_Parallel would, with the
+//  passes fused over cache-resident tiles: each tile reads 3 more samples of halo on either side
+//  per pass. iterated_median_root stops filtering a tile once a pass leaves it unchanged, and
+//  returns the number of passes that changed the signal; when that is below 'max_passes', the
+//  output is a root of the median filter. median_Parallel_chunk_tracked is median_Parallel_chunk
+//  returning whether any output differs from the input sample at its position.
+//
+bool median_Parallel_chunk_tracked(const float*, float*, size_t, bool lead_halo, bool trail_halo);
+void iterated_median(const float*, float*, size_t, size_t passes);
+size_t iterated_median_root(const float*, float*, size_t, size_t max_passes);
+void iterated_median_Cpp(const float*, float*, size_t, size_t passes);
+size_t iterated_median_root_Cpp(const float*, float*, size_t, size_t max_passes);
+
+//- Multichannel input: 'frames' frames of 'channels' interleaved samples (e.g. LRLR or RGBRGB);
+//  each channel is filtered independently and written back interleaved. Strided input: every
+//  'src_stride'-th sample is filtered and written to every 'dst_stride'-th output (both strides
+//  below 2^27 samples).
+//
+void median_Parallel_interleaved(const float*, float*, size_t frames, size_t channels);
+void median_Parallel_strided(const float*, size_t src_stride, float*, size_t dst_stride, size_t);
+
+//- Many short independent series: 'count' series of 'lens[i]' samples, and 'rows' series of
+//  'len' samples each laid out 'src_stride' / 'dst_stride' samples apart. Up to 16 series are
+//  filtered together, one per lane; series longer than 48 samples (rows longer than 80) are
+//  forwarded to median_Parallel.
+//
+void median_batch(const float* const* srcs, float* const* dsts, const size_t* lens, size_t count);
+void median_rows(const float*, size_t src_stride, float*, size_t dst_stride, size_t len, size_t rows);
+
+void median_Cpp(const float*, float*, size_t, size_t window);
+void median_Running(const float*, float*, size_t, size_t window);
+
+template<int Radius> void median_filter(const float*, float*, size_t);
+
+//- Weighted median of the 7-tap window, edges replicated: tap j (offsets -3 .. 3) counts
+//  'Weights[j]' times, and the weights must add up to an odd count of at most 64. The center
+//  weighted median counts the center sample 'CenterWeight' times and every other tap once.
+//  The library instantiates the weights 1 1 1 1 1 1 1, 0 1 1 1 1 1 0, 1 2 2 3 2 2 1 and
+//  1 2 3 5 3 2 1, and center weights 1, 3 and 5; translation units compiled for AVX-512 include
+//  weighted_median.h to instantiate others. weighted_median_Cpp, with the 7 weights passed at
+//  run time, is the reference.
+//
+template<int... Weights> void weighted_median(const float*, float*, size_t);
+template<int CenterWeight> void center_weighted_median(const float*, float*, size_t);
+
+void weighted_median_Cpp(const float*, float*, size_t, const int* weights);
+
+//- Rank-order filter: output i is the sample of rank 'K' (0 = smallest) among the W samples
+//  i - W / 2 .. i + W / 2, edges replicated, for odd W from 3 to 15. K = 0 and K = W - 1 give the
+//  rolling minimum and maximum, K = W / 2 the median; every such W and K is instantiated. The
+//  second form filters several ranks of the same window in one pass, rank 'K...' into 'pdsts[0]'
+//  and on; the library instantiates the rank sets { 0, 3, 6 } of 7, { 0, 4, 8 } of 9,
+//  { 0, 1, 5, 9, 10 } of 11 and { 0, 1, 7, 13, 14 } of 15, and translation units compiled for
+//  AVX-512 include rank_filter.h to instantiate others. rank_Cpp is the reference.
+//
+template<int W, int K> void rank_filter(const float*, float*, size_t);
+template<int W, int... K> void rank_filter(const float*, float* const* pdsts, size_t);
+
+void rank_Cpp(const float*, float*, size_t, size_t window, size_t rank);
+
+//- Rolling minimum (erosion) and maximum (dilation) over an odd 'window' of any length, edges
+//  replicated, at a constant cost per sample; the opening is the dilation of the erosion and the
+//  closing the erosion of the dilation, both passes fused per tile. 'pdst' must not overlap
+//  'psrc'. rank_Cpp with rank 0 and 'window' - 1 is the reference.
+//
+void min_filter(const float*, float*, size_t, size_t window);
+void max_filter(const float*, float*, size_t, size_t window);
+void opening_filter(const float*, float*, size_t, size_t window);
+void closing_filter(const float*, float*, size_t, size_t window);
+
+//- 2D median over a 'window' x 'window' square ((2 * Radius + 1) squared for median_filter_2d,
+//  Radius 1 .. 3) of a 'width' x 'height' image. Strides are in samples; the edges of the image
+//  are replicated.
+//
+void median_Cpp_2d(const float*, size_t src_stride, float*, size_t dst_stride, size_t width, size_t height, size_t window);
+template<int Radius> void median_filter_2d(const float*, size_t src_stride, float*, size_t dst_stride, size_t width, size_t height);
+
+//- Integer sample types; instantiated for uint8_t, int16_t, uint16_t and int32_t.
+//
+template<typename T> void median_Cpp(const T*, T*, size_t);
+template<typename T> void median_Parallel(const T*, T*, size_t);
+template<typename T> void median_Parallel_avx2(const T*, T*, size_t);
+template<typename T> void median_Parallel_chunk(const T*, T*, size_t, bool lead_halo, bool trail_halo);
+template<typename T> void median_Parallel_mt(const T*, T*, size_t, size_t threads);
+
+//- Double precision, 8 samples per AVX-512 register or 4 per AVX2 register; the reference is
+//  median_Cpp<double>.
+//
+void median_Parallel(const double*, double*, size_t);
+void median_Parallel_step1(const double*, double*, size_t);
+void median_Parallel_avx2(const double*, double*, size_t);
+void median_Parallel_step1_avx2(const double*, double*, size_t);
+
+//- How the 7-tap median treats NaN samples. The plain kernels are Unchecked: they assume NaN-free
+//  input, and a NaN anywhere in a window gives an unspecified output for it (median_Cpp's
+//  std::sort is even undefined). The other policies are for inputs such as sensor streams with
+//  dropouts; for all of them the edges are replicated as usual, and the NaN outputs they produce
+//  are the canonical quiet NaN.
+//
+enum class NanPolicy
+{
+    Unchecked,      //- Caller guarantees NaN-free input; forwards to the plain kernel at no cost
+    Propagate,      //- Any NaN in the window makes the output NaN
+    Ignore,         //- Median of the window's non-NaN samples; the mean of the middle two if
+                    //  their count is even, NaN if there are none
+    AsInfinity,     //- NaN is taken as +Inf
+};
+
+template<NanPolicy Policy> void median_Cpp(const float*, float*, size_t);
+template<NanPolicy Policy> void median_Parallel(const float*, float*, size_t);
+
+template<> inline void median_Cpp<NanPolicy::Unchecked>(const float* psrc, float* pdst, size_t buf_len)
+{
+    median_Cpp(psrc, pdst, buf_len);
+}
+
+template<> inline void median_Parallel<NanPolicy::Unchecked>(const float* psrc, float* pdst, size_t buf_len)
+{
+    median_Parallel(psrc, pdst, buf_len);
+}
+
+//- How the 7-tap median extends the input past its ends, after scipy.ndimage; for the input
+//  a b c d the 3 samples read on either side are
+//
+//      Replicate:  a a a | a b c d | d d d     (the plain kernels)
+//      Reflect:    c b a | a b c d | d c b
+//      Mirror:     d c b | a b c d | c b a
+//      Wrap:       b c d | a b c d | a b c
+//      Constant:   k k k | a b c d | k k k     (k is the 'constant' argument)
+//
+//  Valid does not extend the input; output k is the median of samples k .. k + 6, so 'len' - 6
+//  outputs are written, and none when 'len' < 7. The modes only differ in the 3 outputs at
+//  either end; the rest are computed by the same kernels as median_Parallel.
+//
+enum class BoundaryMode
+{
+    Replicate,
+    Reflect,
+    Mirror,
+    Wrap,
+    Constant,
+    Valid,
+};
+
+//- Index of the input sample at position 'i' of the extended input, or -1 for a position that
+//  takes the constant.
+//
+constexpr ptrdiff_t
+boundary_index(BoundaryMode mode, ptrdiff_t i, ptrdiff_t len)
+{
+    if (i >= 0 && i < len)
+    {
+        return i;
+    }
+    switch (mode)
+    {
+        case BoundaryMode::Reflect:
+        {
+            ptrdiff_t const     m = ((i % (2 * len)) + 2 * len) % (2 * len);
+            return (m < len) ? m : 2 * len - 1 - m;
+        }
+        case BoundaryMode::Mirror:
+        {
+            if (len == 1)
+            {
+                return 0;
+            }
+            ptrdiff_t const     period = 2 * len - 2;
+            ptrdiff_t const     m = ((i % period) + period) % period;
+            return (m < len) ? m : period - m;
+        }
+        case BoundaryMode::Wrap:
+            return ((i % len) + len) % len;
+        case BoundaryMode::Constant:
+            return -1;
+        default:
+            return (i < 0) ? 0 : len - 1;
+    }
+}
+
+//- Instantiated for float, uint8_t, int16_t, uint16_t and int32_t.
+//
+template<BoundaryMode Mode, typename T> void median_Cpp(const T*, T*, size_t, T constant = T());
+template<BoundaryMode Mode, typename T> void median_Parallel(const T*, T*, size_t, T constant = T());
+
+//- 7-tap median through the best kernel for the host CPU. The kernel is picked from CPUID once
+//  at startup; setting the environment variable AVX_MEDIAN_KERNEL to one of the names returned
+//  by median_kernel_name() forces a given kernel instead, e.g. for A/B benchmarking.
+//
+enum class MedianKernel
+{
+    Cpp,            //- median_Cpp
+    AVX2,           //- median_Parallel_avx2
+    AVX512,         //- median_Parallel
+    AVX512Step1,    //- median_Parallel_step1
+};
+
+void            median7(const float*, float*, size_t);
+MedianKernel    median7_kernel();
+bool            median_kernel_supported(MedianKernel);
+const char*     median_kernel_name(MedianKernel);
+
+#ifdef _MSC_VER
+#define KEWB_FORCE_INLINE __forceinline
+#else
+#define KEWB_FORCE_INLINE __attribute__((__always_inline__)) inline
+#endif
+
+//- The AVX-512 primitives below are only visible to translation units compiled for AVX-512;
+//  everything else (the scalar reference, the dispatcher and the benchmark harness) must stay
+//  runnable on hosts without it.
+//
+#ifdef __AVX512F__
+
+using rf512 = __m512;
+using ri512 = __m512i;
+using r512f = __m512;
+
+using m512 = uint32_t;
+
+void dump_reg(const char* const name, rf512 value);
+void dump_reg(const char* const name, ri512 value);
+#define DUMP_REG(r) dump_reg(#r, r)
+
+KEWB_FORCE_INLINE r512f
+    load_from(float const* psrc)
+{
+    return _mm512_loadu_ps(psrc);
+}
+
+KEWB_FORCE_INLINE r512f
+    masked_load_from(float const* psrc, r512f fill, m512 mask)
+{
+    return _mm512_mask_loadu_ps(fill, (__mmask16)mask, psrc);
+}
+
+KEWB_FORCE_INLINE __m512
+    load_value(float v)
+{
+    return _mm512_set1_ps(v);
+}
+
+KEWB_FORCE_INLINE void
+    store_to_address(void* pdst, rf512 r)
+{
+    _mm512_mask_storeu_ps(pdst, (__mmask16)0xFFFFu, r);
+}
+
+KEWB_FORCE_INLINE void
+store_to_address(void* pdst, ri512 r)
+{
+    _mm512_mask_storeu_epi32(pdst, (__mmask16)0xFFFFu, r);
+}
+
+KEWB_FORCE_INLINE void
+    masked_store_to(void* pdst, __m512 r, m512 mask)
+{
+    _mm512_mask_storeu_ps(pdst, (__mmask16)mask, r);
+}
+
+template<int A, int B, int C, int D, int E, int F, int G, int H,
+    int I, int J, int K, int L, int M, int N, int O, int P>
+    KEWB_FORCE_INLINE __m512i
+    load_values()
+{
+    return _mm512_setr_epi32(A, B, C, D, E, F, G, H, I, J, K, L, M, N, O, P);
+}
+
+KEWB_FORCE_INLINE __m512
+    blend(__m512 r0, __m512 r1, uint32_t mask)
+{
+    return _mm512_mask_blend_ps((__mmask16)mask, r0, r1);
+}
+
+KEWB_FORCE_INLINE __m512
+    permute(__m512 r, __m512i perm)
+{
+    return _mm512_permutexvar_ps(perm, r);
+}
+
+template<int BIAS, uint32_t MASK, int LANES = 16>
+KEWB_FORCE_INLINE __m512i
+    make_shift_permutation()
+{
+    static_assert(LANES == 16 || LANES == 8);
+
+    if constexpr (LANES == 8)
+    {
+        constexpr int64_t   a = ((BIAS + 0) % 8) | ((MASK & 1u) ? 0x8 : 0);
+        constexpr int64_t   b = ((BIAS + 1) % 8) | ((MASK & 1u << 1u) ? 0x8 : 0);
+        constexpr int64_t   c = ((BIAS + 2) % 8) | ((MASK & 1u << 2u) ? 0x8 : 0);
+        constexpr int64_t   d = ((BIAS + 3) % 8) | ((MASK & 1u << 3u) ? 0x8 : 0);
+        constexpr int64_t   e = ((BIAS + 4) % 8) | ((MASK & 1u << 4u) ? 0x8 : 0);
+        constexpr int64_t   f = ((BIAS + 5) % 8) | ((MASK & 1u << 5u) ? 0x8 : 0);
+        constexpr int64_t   g = ((BIAS + 6) % 8) | ((MASK & 1u << 6u) ? 0x8 : 0);
+        constexpr int64_t   h = ((BIAS + 7) % 8) | ((MASK & 1u << 7u) ? 0x8 : 0);
+
+        return _mm512_setr_epi64(a, b, c, d, e, f, g, h);
+    }
+    else
+    {
+        constexpr int32_t   a = ((BIAS + 0) % 16) | ((MASK & 1u) ? 0x10 : 0);
+        constexpr int32_t   b = ((BIAS + 1) % 16) | ((MASK & 1u << 1u) ? 0x10 : 0);
+        constexpr int32_t   c = ((BIAS + 2) % 16) | ((MASK & 1u << 2u) ? 0x10 : 0);
+        constexpr int32_t   d = ((BIAS + 3) % 16) | ((MASK & 1u << 3u) ? 0x10 : 0);
+        constexpr int32_t   e = ((BIAS + 4) % 16) | ((MASK & 1u << 4u) ? 0x10 : 0);
+        constexpr int32_t   f = ((BIAS + 5) % 16) | ((MASK & 1u << 5u) ? 0x10 : 0);
+        constexpr int32_t   g = ((BIAS + 6) % 16) | ((MASK & 1u << 6u) ? 0x10 : 0);
+        constexpr int32_t   h = ((BIAS + 7) % 16) | ((MASK & 1u << 7u) ? 0x10 : 0);
+        constexpr int32_t   i = ((BIAS + 8) % 16) | ((MASK & 1u << 8u) ? 0x10 : 0);
+        constexpr int32_t   j = ((BIAS + 9) % 16) | ((MASK & 1u << 9u) ? 0x10 : 0);
+        constexpr int32_t   k = ((BIAS + 10) % 16) | ((MASK & 1u << 10u) ? 0x10 : 0);
+        constexpr int32_t   l = ((BIAS + 11) % 16) | ((MASK & 1u << 11u) ? 0x10 : 0);
+        constexpr int32_t   m = ((BIAS + 12) % 16) | ((MASK & 1u << 12u) ? 0x10 : 0);
+        constexpr int32_t   n = ((BIAS + 13) % 16) | ((MASK & 1u << 13u) ? 0x10 : 0);
+        constexpr int32_t   o = ((BIAS + 14) % 16) | ((MASK & 1u << 14u) ? 0x10 : 0);
+        constexpr int32_t   p = ((BIAS + 15) % 16) | ((MASK & 1u << 15u) ? 0x10 : 0);
+
+        return _mm512_setr_epi32(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);
+    }
+}
+
+template<int R>
+KEWB_FORCE_INLINE __m512
+    rotate(__m512 r0)
+{
+    if constexpr ((R % 16) == 0)
+    {
+        return r0;
+    }
+    else
+    {
+        constexpr int    S = (R > 0) ? (16 - (R % 16)) : -R;
+        constexpr int    A = (S + 0) % 16;
+        constexpr int    B = (S + 1) % 16;
+        constexpr int    C = (S + 2) % 16;
+        constexpr int    D = (S + 3) % 16;
+        constexpr int    E = (S + 4) % 16;
+        constexpr int    F = (S + 5) % 16;
+        constexpr int    G = (S + 6) % 16;
+        constexpr int    H = (S + 7) % 16;
+        constexpr int    I = (S + 8) % 16;
+        constexpr int    J = (S + 9) % 16;
+        constexpr int    K = (S + 10) % 16;
+        constexpr int    L = (S + 11) % 16;
+        constexpr int    M = (S + 12) % 16;
+        constexpr int    N = (S + 13) % 16;
+        constexpr int    O = (S + 14) % 16;
+        constexpr int    P = (S + 15) % 16;
+
+        return _mm512_permutexvar_ps(_mm512_setr_epi32(A, B, C, D, E, F, G, H, I, J, K, L, M, N, O, P), r0);
+    }
+}
+
+template<int R>
+KEWB_FORCE_INLINE __m512
+    rotate_up(__m512 r0)
+{
+    static_assert(R >= 0);
+    return rotate<R>(r0);
+}
+
+template<int S>
+KEWB_FORCE_INLINE void
+    in_place_shift_down_with_carry(__m512& lo, __m512& hi)
+{
+    static_assert(S >= 0 && S <= 16);
+
+    constexpr uint32_t  zmask = (0xFFFFu >> (unsigned)S);
+    constexpr uint32_t  bmask = ~zmask & 0xFFFFu;
+    __m512i             perm = make_shift_permutation<S, bmask>();
+
+    lo = _mm512_permutex2var_ps(lo, perm, hi);
+    hi = _mm512_maskz_permutex2var_ps((__mmask16)zmask, hi, perm, hi);
+}
+
+
+template<int S, int LANES = 16>
+KEWB_FORCE_INLINE constexpr uint32_t
+    shift_up_blend_mask()
+{
+    static_assert(S >= 0 && S <= LANES);
+    return (0xFFFFu << (unsigned)S) & (0xFFFFu >> (16u - LANES));
+}
+
+template<int S>
+KEWB_FORCE_INLINE __m512
+    shift_up_with_carry(__m512 lo, __m512 hi)
+{
+    return blend(rotate_up<S>(lo), rotate_up<S>(hi), shift_up_blend_mask<S>());
+}
+
+//- Returns the input data window at offset D from the elements of 'curr', i.e. lane i holds
+//  element i + D of the concatenation 'prev | curr | next'.
+//
+template<int D>
+KEWB_FORCE_INLINE __m512
+    window_tap(__m512 prev, __m512 curr, __m512 next)
+{
+    static_assert(D >= -16 && D <= 16);
+
+    if constexpr (D < 0)
+    {
+        return shift_up_with_carry<-D>(prev, curr);
+    }
+    else if constexpr (D == 0)
+    {
+        return curr;
+    }
+    else
+    {
+        return shift_up_with_carry<16 - D>(curr, next);
+    }
+}
+
+KEWB_FORCE_INLINE __m512
+    mask_permute(__m512 r0, __m512 r1, __m512i perm, uint32_t mask)
+{
+    return _mm512_mask_permutexvar_ps(r0, (__mmask16)mask, perm, r1);
+}
+
+KEWB_FORCE_INLINE __m512
+    minimum(__m512 r0, __m512 r1)
+{
+    return _mm512_min_ps(r0, r1);
+}
+
+__m512
+    KEWB_FORCE_INLINE maximum(__m512 r0, __m512 r1)
+{
+    return _mm512_max_ps(r0, r1);
+}
+
+KEWB_FORCE_INLINE __m512
+mask_minimum(__m512 old, __m512 r0, __m512 r1, m512 mask)
+{
+    return _mm512_mask_min_ps(old, mask, r0, r1);
+}
+
+KEWB_FORCE_INLINE __m512
+mask_maximum(__m512 old, __m512 r0, __m512 r1, m512 mask)
+{
+    return _mm512_mask_max_ps(old, mask, r0, r1);
+}
+
+KEWB_FORCE_INLINE __m512
+    compare_with_exchange(__m512 vals, __m512i perm, m512 mask)
+{
+    __m512  exch = permute(vals, perm);
+    __m512  vmin = minimum(vals, exch);
+    __m512  vmax = maximum(vals, exch);
+
+    return blend(vmin, vmax, mask);
+}
+
+template<unsigned A = 0, unsigned B = 0, unsigned C = 0, unsigned D = 0,
+    unsigned E = 0, unsigned F = 0, unsigned G = 0, unsigned H = 0,
+    unsigned I = 0, unsigned J = 0, unsigned K = 0, unsigned L = 0,
+    unsigned M = 0, unsigned N = 0, unsigned O = 0, unsigned P = 0>
+    KEWB_FORCE_INLINE constexpr uint32_t
+    make_bitmask()
+{
+    static_assert((A < 2) && (B < 2) && (C < 2) && (D < 2) &&
+        (E < 2) && (F < 2) && (G < 2) && (H < 2) &&
+        (I < 2) && (J < 2) && (K < 2) && (L < 2) &&
+        (M < 2) && (N < 2) && (O < 2) && (P < 2));
+
+    return ((A << 0) | (B << 1) | (C << 2) | (D << 3) |
+        (E << 4) | (F << 5) | (G << 6) | (H << 7) |
+        (I << 8) | (J << 9) | (K << 10) | (L << 11) |
+        (M << 12) | (N << 13) | (O << 14) | (P << 15));
+}
+
+template<unsigned... IDXS>
+KEWB_FORCE_INLINE auto
+    make_permute()
+{
+    static_assert(sizeof...(IDXS) == 8 || sizeof...(IDXS) == 16);
+
+    if constexpr (sizeof...(IDXS) == 8)
+    {
+        return _mm256_setr_epi32(IDXS...);
+    }
+    else
+    {
+        return load_values<IDXS...>();
+    }
+}
+
+KEWB_FORCE_INLINE __m512
+    sort_two_lanes_of_7(rf512 vals)
+{
+    //- Precompute the permutations and bitmasks for the 6 stages of this bitonic sorting sequence.
+    //                                   0   1   2   3   4   5   6   7     0   1   2   3   4   5   6   7
+    //                                  ---------------------------------------------------
+    ri512 const     perm0 = make_permute<4, 5, 6, 3, 0, 1, 2, 7, 12, 13, 14, 11, 8, 9, 10, 15>();
+    constexpr m512  mask0 = make_bitmask<0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 1, 1, 1, 0>();
+
+    ri512 const     perm1 = make_permute<2, 3, 0, 1, 6, 5, 4, 7, 10, 11, 8, 9, 14, 13, 12, 15>();
+    constexpr m512  mask1 = make_bitmask<0, 0, 1, 1, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 1, 0>();
+
+    ri512 const     perm2 = make_permute<1, 0, 4, 5, 2, 3, 6, 7, 9, 8, 12, 13, 10, 11, 14, 15>();
+    constexpr m512  mask2 = make_bitmask<0, 1, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0>();
+
+    ri512 const     perm3 = make_permute<0, 1, 3, 2, 5, 4, 6, 7, 8, 9, 11, 10, 13, 12, 14, 15>();
+    constexpr m512  mask3 = make_bitmask<0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0>();
+
+    ri512 const     perm4 = make_permute<0, 4, 2, 6, 1, 5, 3, 7, 8, 12, 10, 14, 9, 13, 11, 15>();
+    constexpr m512  mask4 = make_bitmask<0, 0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0>();
+
+    ri512 const     perm5 = make_permute<0, 2, 1, 4, 3, 6, 5, 7, 8, 10, 9, 12, 11, 14, 13, 15>();
+    constexpr m512  mask5 = make_bitmask<0, 0, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 1, 0, 1, 0>();
+
+    vals = compare_with_exchange(vals, perm0, mask0);
+    vals = compare_with_exchange(vals, perm1, mask1);
+    vals = compare_with_exchange(vals, perm2, mask2);
+    vals = compare_with_exchange(vals, perm3, mask3);
+    vals = compare_with_exchange(vals, perm4, mask4);
+    vals = compare_with_exchange(vals, perm5, mask5);
+
+    return vals;
+}
+
+//- 8-lane double precision counterparts of the primitives above.
+//
+using rd512 = __m512d;
+
+KEWB_FORCE_INLINE rd512
+    load_from(double const* psrc)
+{
+    return _mm512_loadu_pd(psrc);
+}
+
+KEWB_FORCE_INLINE rd512
+    masked_load_from(double const* psrc, rd512 fill, m512 mask)
+{
+    return _mm512_mask_loadu_pd(fill, (__mmask8)mask, psrc);
+}
+
+KEWB_FORCE_INLINE rd512
+    load_value(double v)
+{
+    return _mm512_set1_pd(v);
+}
+
+KEWB_FORCE_INLINE void
+    store_to_address(void* pdst, rd512 r)
+{
+    _mm512_storeu_pd(pdst, r);
+}
+
+KEWB_FORCE_INLINE void
+    masked_store_to(void* pdst, rd512 r, m512 mask)
+{
+    _mm512_mask_storeu_pd(pdst, (__mmask8)mask, r);
+}
+
+template<int64_t A, int64_t B, int64_t C, int64_t D, int64_t E, int64_t F, int64_t G, int64_t H>
+KEWB_FORCE_INLINE __m512i
+    make_permute64()
+{
+    return _mm512_setr_epi64(A, B, C, D, E, F, G, H);
+}
+
+KEWB_FORCE_INLINE rd512
+    blend(rd512 r0, rd512 r1, uint32_t mask)
+{
+    return _mm512_mask_blend_pd((__mmask8)mask, r0, r1);
+}
+
+KEWB_FORCE_INLINE rd512
+    permute(rd512 r, __m512i perm)
+{
+    return _mm512_permutexvar_pd(perm, r);
+}
+
+KEWB_FORCE_INLINE rd512
+    mask_permute(rd512 r0, rd512 r1, __m512i perm, uint32_t mask)
+{
+    return _mm512_mask_permutexvar_pd(r0, (__mmask8)mask, perm, r1);
+}
+
+KEWB_FORCE_INLINE rd512
+    minimum(rd512 r0, rd512 r1)
+{
+    return _mm512_min_pd(r0, r1);
+}
+
+KEWB_FORCE_INLINE rd512
+    maximum(rd512 r0, rd512 r1)
+{
+    return _mm512_max_pd(r0, r1);
+}
+
+template<int R>
+KEWB_FORCE_INLINE rd512
+    rotate(rd512 r0)
+{
+    if constexpr ((R % 8) == 0)
+    {
+        return r0;
+    }
+    else
+    {
+        constexpr int    S = (R > 0) ? (8 - (R % 8)) : -R;
+        constexpr int    A = (S + 0) % 8;
+        constexpr int    B = (S + 1) % 8;
+        constexpr int    C = (S + 2) % 8;
+        constexpr int    D = (S + 3) % 8;
+        constexpr int    E = (S + 4) % 8;
+        constexpr int    F = (S + 5) % 8;
+        constexpr int    G = (S + 6) % 8;
+        constexpr int    H = (S + 7) % 8;
+
+        return _mm512_permutexvar_pd(_mm512_setr_epi64(A, B, C, D, E, F, G, H), r0);
+    }
+}
+
+template<int R>
+KEWB_FORCE_INLINE rd512
+    rotate_up(rd512 r0)
+{
+    static_assert(R >= 0);
+    return rotate<R>(r0);
+}
+
+template<int S>
+KEWB_FORCE_INLINE void
+    in_place_shift_down_with_carry(rd512& lo, rd512& hi)
+{
+    static_assert(S >= 0 && S <= 8);
+
+    constexpr uint32_t  zmask = (0xFFu >> (unsigned)S);
+    constexpr uint32_t  bmask = ~zmask & 0xFFu;
+    __m512i             perm = make_shift_permutation<S, bmask, 8>();
+
+    lo = _mm512_permutex2var_pd(lo, perm, hi);
+    hi = _mm512_maskz_permutex2var_pd((__mmask8)zmask, hi, perm, hi);
+}
+
+template<int S>
+KEWB_FORCE_INLINE rd512
+    shift_up_with_carry(rd512 lo, rd512 hi)
+{
+    return blend(rotate_up<S>(lo), rotate_up<S>(hi), shift_up_blend_mask<S, 8>());
+}
+
+template<int D>
+KEWB_FORCE_INLINE rd512
+    window_tap(rd512 prev, rd512 curr, rd512 next)
+{
+    static_assert(D >= -8 && D <= 8);
+
+    if constexpr (D < 0)
+    {
+        return shift_up_with_carry<-D>(prev, curr);
+    }
+    else if constexpr (D == 0)
+    {
+        return curr;
+    }
+    else
+    {
+        return shift_up_with_carry<8 - D>(curr, next);
+    }
+}
+
+#endif
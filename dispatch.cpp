@@ -0,0 +1,149 @@
+#include "avx-median.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//- This translation unit is compiled for the baseline instruction set; it only inspects the
+//  CPU and forwards to kernels that live in their own, separately targeted translation units.
+//
+
+#ifdef _MSC_VER
+
+static bool cpu_has(int leaf, int subleaf, int reg, unsigned bits)
+{
+    int     info[4];
+
+    __cpuidex(info, leaf, subleaf);
+    return ((unsigned)info[reg] & bits) == bits;
+}
+
+static bool cpu_has_avx2()
+{
+    //- OSXSAVE + AVX, the OS saving YMM state, then AVX2.
+    //
+    return cpu_has(1, 0, 2, (1u << 27) | (1u << 28)) &&
+        ((_xgetbv(0) & 0x06) == 0x06) &&
+        cpu_has(7, 0, 1, 1u << 5);
+}
+
+static bool cpu_has_avx512()
+{
+    //- F, DQ, CD, BW and VL (the skylake-avx512 set), and the OS saving ZMM state.
+    //
+    return cpu_has_avx2() &&
+        ((_xgetbv(0) & 0xE6) == 0xE6) &&
+        cpu_has(7, 0, 1, (1u << 16) | (1u << 17) | (1u << 28) | (1u << 30) | (1u << 31));
+}
+
+#else
+
+static bool cpu_has_avx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static bool cpu_has_avx512()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+        __builtin_cpu_supports("avx512cd") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vl");
+}
+
+#endif
+
+bool median_kernel_supported(MedianKernel kernel)
+{
+    switch (kernel)
+    {
+    case MedianKernel::AVX512Step1:
+    case MedianKernel::AVX512:
+        return cpu_has_avx512();
+    case MedianKernel::AVX2:
+        return cpu_has_avx2();
+    default:
+        return true;
+    }
+}
+
+const char* median_kernel_name(MedianKernel kernel)
+{
+    switch (kernel)
+    {
+    case MedianKernel::AVX512Step1:
+        return "avx512_step1";
+    case MedianKernel::AVX512:
+        return "avx512";
+    case MedianKernel::AVX2:
+        return "avx2";
+    default:
+        return "cpp";
+    }
+}
+
+static MedianKernel select_kernel()
+{
+    constexpr MedianKernel  preference[] = { MedianKernel::AVX512Step1, MedianKernel::AVX512,
+                                             MedianKernel::AVX2, MedianKernel::Cpp };
+
+    if (const char* forced = std::getenv("AVX_MEDIAN_KERNEL"))
+    {
+        for (MedianKernel kernel : preference)
+        {
+            if (std::strcmp(forced, median_kernel_name(kernel)) == 0)
+            {
+                if (median_kernel_supported(kernel))
+                {
+                    return kernel;
+                }
+                std::cerr << "AVX_MEDIAN_KERNEL=" << forced << " is not supported by this CPU; ignored\n";
+                break;
+            }
+        }
+    }
+
+    for (MedianKernel kernel : preference)
+    {
+        if (median_kernel_supported(kernel))
+        {
+            return kernel;
+        }
+    }
+    return MedianKernel::Cpp;
+}
+
+using median_fn = void (*)(const float*, float*, size_t);
+
+static median_fn kernel_function(MedianKernel kernel)
+{
+    switch (kernel)
+    {
+    case MedianKernel::AVX512Step1:
+        return median_Parallel_step1;
+    case MedianKernel::AVX512:
+        return median_Parallel;
+    case MedianKernel::AVX2:
+        return median_Parallel_avx2;
+    default:
+        return median_Cpp;
+    }
+}
+
+static MedianKernel const   selected_kernel = select_kernel();
+static median_fn const      selected_function = kernel_function(selected_kernel);
+
+void median7(const float* psrc, float* pdst, size_t buf_len)
+{
+    selected_function(psrc, pdst, buf_len);
+}
+
+MedianKernel median7_kernel()
+{
+    return selected_kernel;
+}
@@ -0,0 +1,155 @@
+#include "avx-median.h"
+
+#include <algorithm>
+#include <vector>
+
+//- The passes of an iterated median are fused over tiles of the signal small enough for the
+//  intermediate results to stay in cache. Every pass of a tile is filtered by the chunk kernel
+//  with the previous pass as its halo, so a tile of 'count' outputs starts from 'count' plus
+//  3 * passes input samples on either side, and each pass leaves 3 fewer valid samples at each
+//  interior side; the true ends of the signal are replicated by every pass, as median_Parallel
+//  does. The first pass reads the input directly and the last writes the output; the passes in
+//  between alternate between two scratch buffers.
+//
+namespace
+{
+
+constexpr size_t    tile_size = 2048;
+
+//- Scratch for the tiles of one call. A tile is at least 16 times the halo it reads on either
+//  side; the last tile also takes the remainder of the signal, so every interior side of a tile
+//  is backed by 'halo' real samples.
+//
+struct Tile
+{
+    explicit Tile(size_t passes)
+    :   halo(3 * passes),
+        outputs(std::max(tile_size, 16 * halo)),
+        size(2 * outputs + 2 * halo),
+        stage(), a(size), b(size)
+    {}
+
+    size_t              halo;
+    size_t              outputs;
+    size_t              size;
+    std::vector<float>  stage;  //- Copy of the input of a tile when filtering in place
+    std::vector<float>  a;
+    std::vector<float>  b;
+};
+
+//- Filters one tile; returns the number of passes that changed it. With 'Root', the tile is
+//  finished as soon as a pass leaves it unchanged: that pass read the same input as the next one
+//  would over all the samples the next one depends on, so every pass after it is the identity.
+//
+template<bool Root>
+size_t filter_tile(const float* px, float* pdst, size_t begin, size_t end, size_t buf_len, size_t passes, Tile& tile)
+{
+    bool const      lead_halo = (begin != 0);
+    bool const      trail_halo = (end != buf_len);
+    size_t const    first = lead_halo ? tile.halo : 0;  //- Offset of the tile's outputs in 'px'
+    size_t const    count = end - begin - first - (trail_halo ? tile.halo : 0);
+    float* const    scratch[] = { tile.a.data(), tile.b.data() };
+    const float*    in = px;
+    size_t          lo = 0;
+    size_t          hi = end - begin;
+
+    for (size_t pass = 1; pass <= passes; ++pass)
+    {
+        lo += lead_halo ? 3 : 0;
+        hi -= trail_halo ? 3 : 0;
+
+        float* const    out = (pass == passes) ? pdst + begin : scratch[pass % 2];
+
+        if constexpr (Root)
+        {
+            if (!median_Parallel_chunk_tracked(in + lo, out + lo, hi - lo, lead_halo, trail_halo))
+            {
+                if (pass != passes)
+                {
+                    std::copy_n(in + first, count, pdst + begin + first);
+                }
+                return pass - 1;
+            }
+        }
+        else
+        {
+            median_Parallel_chunk(in + lo, out + lo, hi - lo, lead_halo, trail_halo, false);
+        }
+        in = out;
+    }
+    return passes;
+}
+
+template<bool Root>
+size_t iterate(const float* psrc, float* pdst, size_t buf_len, size_t passes)
+{
+    if (buf_len == 0)
+    {
+        return 0;
+    }
+    if (passes == 0)
+    {
+        if (psrc != pdst)
+        {
+            std::copy_n(psrc, buf_len, pdst);
+        }
+        return 0;
+    }
+
+    Tile            tile(passes);
+    bool const      in_place = (psrc == pdst);
+    size_t const    tiles = std::max<size_t>(buf_len / tile.outputs, 1);
+    size_t          staged_begin = 0;
+    size_t          staged_end = 0;
+    size_t          changed = 0;
+
+    //- In place, each tile starts with a copy of its input: the leading halo has already been
+    //  overwritten by the tile before, and is carried over from that tile's copy.
+    //
+    if (in_place)
+    {
+        tile.stage.resize(tile.size);
+    }
+
+    for (size_t i = 0; i < tiles; ++i)
+    {
+        size_t const    pos = i * tile.outputs;
+        size_t const    count = (i + 1 == tiles) ? buf_len - pos : tile.outputs;
+        size_t const    begin = (i != 0) ? pos - tile.halo : 0;
+        size_t const    end = (i + 1 != tiles) ? pos + count + tile.halo : buf_len;
+        const float*    px = psrc + begin;
+
+        if (in_place)
+        {
+            float* const    stage = tile.stage.data();
+
+            std::copy(stage + (begin - staged_begin), stage + (staged_end - staged_begin), stage);
+            std::copy(psrc + staged_end, psrc + end, stage + (staged_end - begin));
+            staged_begin = begin;
+            staged_end = end;
+            px = stage;
+        }
+
+        changed = std::max(changed, filter_tile<Root>(px, pdst, begin, end, buf_len, passes, tile));
+    }
+    return changed;
+}
+
+}   // namespace
+
+void iterated_median(const float* psrc, float* pdst, size_t buf_len, size_t passes)
+{
+    if (passes == 1)
+    {
+        median_Parallel(psrc, pdst, buf_len);
+    }
+    else
+    {
+        iterate<false>(psrc, pdst, buf_len, passes);
+    }
+}
+
+size_t iterated_median_root(const float* psrc, float* pdst, size_t buf_len, size_t max_passes)
+{
+    return iterate<true>(psrc, pdst, buf_len, max_passes);
+}
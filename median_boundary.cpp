@@ -0,0 +1,106 @@
+#include "avx-median.h"
+
+//- The boundary modes other than Replicate only change the 3 outputs at either end. The bulk
+//  of the buffer is filtered by the chunk kernels with its own outer samples as halos, the way
+//  median_Parallel_mt filters the seams between chunks; the ends are filtered from short copies
+//  of the input padded according to the mode, taken before anything is written so that 'pdst'
+//  may equal 'psrc'.
+//
+namespace
+{
+
+void filter_chunk(const float* psrc, float* pdst, size_t len, bool lead_halo, bool trail_halo)
+{
+    median_Parallel_chunk(psrc, pdst, len, lead_halo, trail_halo, false);
+}
+
+template<typename T>
+void filter_chunk(const T* psrc, T* pdst, size_t len, bool lead_halo, bool trail_halo)
+{
+    median_Parallel_chunk(psrc, pdst, len, lead_halo, trail_halo);
+}
+
+//- Copies positions 'begin' .. 'begin + count - 1' of the extended input into 'pdst'.
+//
+template<BoundaryMode Mode, typename T>
+void pad(const T* psrc, size_t len, ptrdiff_t begin, size_t count, T constant, T* pdst)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        ptrdiff_t const     index = boundary_index(Mode, begin + (ptrdiff_t)i, (ptrdiff_t)len);
+
+        pdst[i] = (index < 0) ? constant : psrc[index];
+    }
+}
+
+}   // namespace
+
+template<BoundaryMode Mode, typename T>
+void median_Parallel(const T* psrc, T* pdst, size_t buf_len, T constant)
+{
+    if constexpr (Mode == BoundaryMode::Replicate)
+    {
+        median_Parallel(psrc, pdst, buf_len);
+    }
+    else if constexpr (Mode == BoundaryMode::Valid)
+    {
+        if (buf_len > 6)
+        {
+            filter_chunk(psrc + 3, pdst, buf_len - 6, true, true);
+        }
+    }
+    else if (buf_len == 0)
+    {
+        return;
+    }
+    else if (buf_len <= 6)
+    {
+        T   padded[12];
+
+        pad<Mode>(psrc, buf_len, -3, buf_len + 6, constant, padded);
+        filter_chunk(padded + 3, pdst, buf_len, true, true);
+    }
+    else
+    {
+        T   head[9];
+        T   tail[9];
+
+        pad<Mode>(psrc, buf_len, -3, 9, constant, head);
+        pad<Mode>(psrc, buf_len, (ptrdiff_t)buf_len - 6, 9, constant, tail);
+
+        filter_chunk(psrc + 3, pdst + 3, buf_len - 6, true, true);
+        filter_chunk(head + 3, pdst, 3, true, true);
+        filter_chunk(tail + 3, pdst + buf_len - 3, 3, true, true);
+    }
+}
+
+template void median_Parallel<BoundaryMode::Replicate>(const float*, float*, size_t, float);
+template void median_Parallel<BoundaryMode::Reflect>(const float*, float*, size_t, float);
+template void median_Parallel<BoundaryMode::Mirror>(const float*, float*, size_t, float);
+template void median_Parallel<BoundaryMode::Wrap>(const float*, float*, size_t, float);
+template void median_Parallel<BoundaryMode::Constant>(const float*, float*, size_t, float);
+template void median_Parallel<BoundaryMode::Valid>(const float*, float*, size_t, float);
+template void median_Parallel<BoundaryMode::Replicate>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Parallel<BoundaryMode::Reflect>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Parallel<BoundaryMode::Mirror>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Parallel<BoundaryMode::Wrap>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Parallel<BoundaryMode::Constant>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Parallel<BoundaryMode::Valid>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Parallel<BoundaryMode::Replicate>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Parallel<BoundaryMode::Reflect>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Parallel<BoundaryMode::Mirror>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Parallel<BoundaryMode::Wrap>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Parallel<BoundaryMode::Constant>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Parallel<BoundaryMode::Valid>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Parallel<BoundaryMode::Replicate>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Parallel<BoundaryMode::Reflect>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Parallel<BoundaryMode::Mirror>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Parallel<BoundaryMode::Wrap>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Parallel<BoundaryMode::Constant>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Parallel<BoundaryMode::Valid>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Parallel<BoundaryMode::Replicate>(const int32_t*, int32_t*, size_t, int32_t);
+template void median_Parallel<BoundaryMode::Reflect>(const int32_t*, int32_t*, size_t, int32_t);
+template void median_Parallel<BoundaryMode::Mirror>(const int32_t*, int32_t*, size_t, int32_t);
+template void median_Parallel<BoundaryMode::Wrap>(const int32_t*, int32_t*, size_t, int32_t);
+template void median_Parallel<BoundaryMode::Constant>(const int32_t*, int32_t*, size_t, int32_t);
+template void median_Parallel<BoundaryMode::Valid>(const int32_t*, int32_t*, size_t, int32_t);
@@ -0,0 +1,315 @@
+#include "avx-median.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+//- The window is a sliding copy of the input, so every sample is read exactly once and 3
+//  positions ahead of the output being written; 'output' may therefore equal 'input'.
+//
+void median_Cpp(const float* input, float* output, size_t size)
+{
+    float   window[7];
+    float   scratch[7];
+
+    if (size == 0)
+    {
+        return;
+    }
+
+    float const     last = input[size - 1];
+
+    // boundary
+    std::fill_n(window, 4, input[0]);
+    for (size_t i = 1; i < 4; ++i)
+    {
+        window[3 + i] = (i < size) ? input[i] : last;
+    }
+
+    for (size_t pos = 0; pos < size; ++pos)
+    {
+        std::copy_n(window, 7, scratch);
+        std::sort(scratch, scratch + 7);
+
+        std::copy_n(window + 1, 6, window);
+        window[6] = (pos + 4 < size) ? input[pos + 4] : last;
+        output[pos] = scratch[3];
+    }
+}
+
+void median_Cpp(const float* input, float* output, size_t size, size_t window)
+{
+    rank_Cpp(input, output, size, window, window / 2);
+}
+
+void rank_Cpp(const float* input, float* output, size_t size, size_t window, size_t rank)
+{
+    std::vector<float>  scratch(window);
+    ptrdiff_t const     radius = (ptrdiff_t)(window / 2);
+    ptrdiff_t const     end = (ptrdiff_t)size - 1;
+
+    for (ptrdiff_t pos = 0; pos <= end; ++pos, ++output)
+    {
+        for (ptrdiff_t i = 0; i < (ptrdiff_t)window; ++i)
+        {
+            scratch[i] = input[std::clamp<ptrdiff_t>(pos - radius + i, 0, end)];
+        }
+        std::nth_element(scratch.begin(), scratch.begin() + rank, scratch.end());
+        *output = scratch[rank];
+    }
+}
+
+void weighted_median_Cpp(const float* input, float* output, size_t size, const int* weights)
+{
+    std::vector<float>  scratch;
+    ptrdiff_t const     end = (ptrdiff_t)size - 1;
+
+    for (ptrdiff_t pos = 0; pos <= end; ++pos, ++output)
+    {
+        scratch.clear();
+        for (ptrdiff_t i = 0; i < 7; ++i)
+        {
+            scratch.insert(scratch.end(), (size_t)weights[i], input[std::clamp<ptrdiff_t>(pos - 3 + i, 0, end)]);
+        }
+
+        size_t const    median = (scratch.size() - 1) / 2;
+
+        std::nth_element(scratch.begin(), scratch.begin() + median, scratch.end());
+        *output = scratch[median];
+    }
+}
+
+void median_Cpp_2d(const float* input, size_t input_stride, float* output, size_t output_stride,
+                   size_t width, size_t height, size_t window)
+{
+    std::vector<float>  scratch(window * window);
+    ptrdiff_t const     radius = (ptrdiff_t)(window / 2);
+    ptrdiff_t const     right = (ptrdiff_t)width - 1;
+    ptrdiff_t const     bottom = (ptrdiff_t)height - 1;
+
+    for (ptrdiff_t y = 0; y <= bottom; ++y)
+    {
+        for (ptrdiff_t x = 0; x <= right; ++x)
+        {
+            float*  next = scratch.data();
+
+            for (ptrdiff_t i = 0; i < (ptrdiff_t)window; ++i)
+            {
+                float const*    row = input + std::clamp<ptrdiff_t>(y - radius + i, 0, bottom) * input_stride;
+
+                for (ptrdiff_t j = 0; j < (ptrdiff_t)window; ++j)
+                {
+                    *next++ = row[std::clamp<ptrdiff_t>(x - radius + j, 0, right)];
+                }
+            }
+            std::nth_element(scratch.begin(), scratch.begin() + scratch.size() / 2, scratch.end());
+            output[y * output_stride + x] = scratch[scratch.size() / 2];
+        }
+    }
+}
+
+template<typename T>
+void median_Cpp(const T* input, T* output, size_t size)
+{
+    T                   scratch[7];
+    ptrdiff_t const     end = (ptrdiff_t)size - 1;
+
+    for (ptrdiff_t pos = 0; pos <= end; ++pos, ++output)
+    {
+        for (ptrdiff_t i = 0; i < 7; ++i)
+        {
+            scratch[i] = input[std::clamp<ptrdiff_t>(pos - 3 + i, 0, end)];
+        }
+        std::sort(scratch, scratch + 7);
+        *output = scratch[3];
+    }
+}
+
+template void median_Cpp<uint8_t>(const uint8_t*, uint8_t*, size_t);
+template void median_Cpp<int16_t>(const int16_t*, int16_t*, size_t);
+template void median_Cpp<uint16_t>(const uint16_t*, uint16_t*, size_t);
+template void median_Cpp<int32_t>(const int32_t*, int32_t*, size_t);
+template void median_Cpp<double>(const double*, double*, size_t);
+
+template<NanPolicy Policy>
+void median_Cpp(const float* input, float* output, size_t size)
+{
+    float               scratch[7];
+    ptrdiff_t const     end = (ptrdiff_t)size - 1;
+    float const         nan = std::numeric_limits<float>::quiet_NaN();
+
+    for (ptrdiff_t pos = 0; pos <= end; ++pos, ++output)
+    {
+        size_t  valid = 0;
+
+        //- NaN-free windows are sorted as usual; NaN samples are left out of the sort, so that
+        //  'scratch' holds the 'valid' numbers in order.
+        //
+        for (ptrdiff_t i = 0; i < 7; ++i)
+        {
+            float const     sample = input[std::clamp<ptrdiff_t>(pos - 3 + i, 0, end)];
+
+            if (!std::isnan(sample))
+            {
+                scratch[valid++] = sample;
+            }
+        }
+        std::sort(scratch, scratch + valid);
+
+        if (valid == 7)
+        {
+            *output = scratch[3];
+        }
+        else if (Policy == NanPolicy::Propagate)
+        {
+            *output = nan;
+        }
+        else if (Policy == NanPolicy::AsInfinity)
+        {
+            *output = (valid > 3) ? scratch[3] : std::numeric_limits<float>::infinity();
+        }
+        else if (valid == 0)
+        {
+            *output = nan;
+        }
+        else
+        {
+            float const     lower = scratch[(valid - 1) / 2];
+            float const     upper = scratch[valid / 2];
+
+            *output = (lower == upper) ? lower : std::fma(lower, 0.5f, upper * 0.5f);
+        }
+    }
+}
+
+template void median_Cpp<NanPolicy::Propagate>(const float*, float*, size_t);
+template void median_Cpp<NanPolicy::Ignore>(const float*, float*, size_t);
+template void median_Cpp<NanPolicy::AsInfinity>(const float*, float*, size_t);
+
+void hampel_Cpp(const float* input, float* output, size_t size, float threshold, uint8_t* outliers)
+{
+    float               window[7];
+    float               scratch[7];
+    float const         scale = threshold * hampel_mad_scale;
+    ptrdiff_t const     end = (ptrdiff_t)size - 1;
+
+    if (outliers != nullptr)
+    {
+        std::fill_n(outliers, (size + 7) / 8, 0);
+    }
+
+    //- The window is gathered from 'input' for every output, so 'output' must not overlap it.
+    //
+    for (ptrdiff_t pos = 0; pos <= end; ++pos)
+    {
+        for (ptrdiff_t i = 0; i < 7; ++i)
+        {
+            window[i] = input[std::clamp<ptrdiff_t>(pos - 3 + i, 0, end)];
+        }
+        std::copy_n(window, 7, scratch);
+        std::sort(scratch, scratch + 7);
+
+        float const     median = scratch[3];
+
+        for (ptrdiff_t i = 0; i < 7; ++i)
+        {
+            scratch[i] = std::fabs(window[i] - median);
+        }
+        std::sort(scratch, scratch + 7);
+
+        bool const      outlier = std::fabs(window[3] - median) > scale * scratch[3];
+
+        output[pos] = outlier ? median : window[3];
+        if (outliers != nullptr && outlier)
+        {
+            outliers[pos / 8] |= (uint8_t)(1u << (pos % 8));
+        }
+    }
+}
+
+void iterated_median_Cpp(const float* input, float* output, size_t size, size_t passes)
+{
+    if (passes == 0)
+    {
+        std::copy_n(input, size, output);
+        return;
+    }
+    median_Cpp(input, output, size);
+    for (size_t pass = 1; pass < passes; ++pass)
+    {
+        median_Cpp(output, output, size);
+    }
+}
+
+//- Unchanged means bit for bit, as in median_Parallel_chunk_tracked.
+//
+size_t iterated_median_root_Cpp(const float* input, float* output, size_t size, size_t max_passes)
+{
+    std::vector<float>  previous(input, input + size);
+
+    std::copy_n(input, size, output);
+    for (size_t pass = 0; pass < max_passes; ++pass)
+    {
+        median_Cpp(previous.data(), output, size);
+        if (std::memcmp(previous.data(), output, size * sizeof(float)) == 0)
+        {
+            return pass;
+        }
+        std::copy_n(output, size, previous.data());
+    }
+    return max_passes;
+}
+
+template<BoundaryMode Mode, typename T>
+void median_Cpp(const T* input, T* output, size_t size, T constant)
+{
+    T                   scratch[7];
+    ptrdiff_t const     len = (ptrdiff_t)size;
+    ptrdiff_t const     first = (Mode == BoundaryMode::Valid) ? 3 : 0;
+    ptrdiff_t const     last = (Mode == BoundaryMode::Valid) ? len - 3 : len;
+
+    for (ptrdiff_t pos = first; pos < last; ++pos, ++output)
+    {
+        for (ptrdiff_t i = 0; i < 7; ++i)
+        {
+            ptrdiff_t const     index = boundary_index(Mode, pos - 3 + i, len);
+
+            scratch[i] = (index < 0) ? constant : input[index];
+        }
+        std::sort(scratch, scratch + 7);
+        *output = scratch[3];
+    }
+}
+
+template void median_Cpp<BoundaryMode::Replicate>(const float*, float*, size_t, float);
+template void median_Cpp<BoundaryMode::Reflect>(const float*, float*, size_t, float);
+template void median_Cpp<BoundaryMode::Mirror>(const float*, float*, size_t, float);
+template void median_Cpp<BoundaryMode::Wrap>(const float*, float*, size_t, float);
+template void median_Cpp<BoundaryMode::Constant>(const float*, float*, size_t, float);
+template void median_Cpp<BoundaryMode::Valid>(const float*, float*, size_t, float);
+template void median_Cpp<BoundaryMode::Replicate>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Cpp<BoundaryMode::Reflect>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Cpp<BoundaryMode::Mirror>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Cpp<BoundaryMode::Wrap>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Cpp<BoundaryMode::Constant>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Cpp<BoundaryMode::Valid>(const uint8_t*, uint8_t*, size_t, uint8_t);
+template void median_Cpp<BoundaryMode::Replicate>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Cpp<BoundaryMode::Reflect>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Cpp<BoundaryMode::Mirror>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Cpp<BoundaryMode::Wrap>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Cpp<BoundaryMode::Constant>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Cpp<BoundaryMode::Valid>(const int16_t*, int16_t*, size_t, int16_t);
+template void median_Cpp<BoundaryMode::Replicate>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Cpp<BoundaryMode::Reflect>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Cpp<BoundaryMode::Mirror>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Cpp<BoundaryMode::Wrap>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Cpp<BoundaryMode::Constant>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Cpp<BoundaryMode::Valid>(const uint16_t*, uint16_t*, size_t, uint16_t);
+template void median_Cpp<BoundaryMode::Replicate>(const int32_t*, int32_t*, size_t, int32_t);
+template void median_Cpp<BoundaryMode::Reflect>(const int32_t*, int32_t*, size_t, int32_t);
+template void median_Cpp<BoundaryMode::Mirror>(const int32_t*, int32_t*, size_t, int32_t);
+template void median_Cpp<BoundaryMode::Wrap>(const int32_t*, int32_t*, size_t, int32_t);
+template void median_Cpp<BoundaryMode::Constant>(const int32_t*, int32_t*, size_t, int32_t);
+template void median_Cpp<BoundaryMode::Valid>(const int32_t*, int32_t*, size_t, int32_t);
@@ -0,0 +1,210 @@
+#include "avx-median.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//- Filters a raw capture file (native-endian float32 or int16 samples) into an output file of the
+//  same size, without reading either into memory: both files are mapped, and the multithreaded
+//  kernel streams through the mappings chunk by chunk. Files larger than RAM work, since the
+//  kernel only ever touches a few chunks per thread at a time.
+//
+//      median-file [--int16] [--threads N] <input> <output>
+//
+namespace
+{
+
+struct Mapping
+{
+    void*   data = MAP_FAILED;
+    size_t  size = 0;
+
+    ~Mapping()
+    {
+        if (data != MAP_FAILED)
+        {
+            munmap(data, size);
+        }
+    }
+};
+
+[[noreturn]] void fail(const char* what, const char* path)
+{
+    std::fprintf(stderr, "median-file: %s '%s': %s\n", what, path, std::strerror(errno));
+    std::exit(1);
+}
+
+[[noreturn]] void usage()
+{
+    std::fprintf(stderr, "usage: median-file [--int16] [--threads N] <input> <output>\n");
+    std::exit(2);
+}
+
+//- Hints for a single sequential pass. Huge pages are requested where the kernel supports them
+//  for the mapping (e.g. files on a tmpfs mounted with huge=); elsewhere the call fails harmlessly.
+//
+void advise(const Mapping& map)
+{
+    madvise(map.data, map.size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    madvise(map.data, map.size, MADV_HUGEPAGE);
+#endif
+}
+
+void filter_float(const float* psrc, float* pdst, size_t len, size_t threads)
+{
+    if (median_kernel_supported(MedianKernel::AVX512))
+    {
+        median_Parallel_mt(psrc, pdst, len, threads);
+    }
+    else
+    {
+        median7(psrc, pdst, len);
+    }
+}
+
+void filter_int16(const int16_t* psrc, int16_t* pdst, size_t len, size_t threads)
+{
+    if (median_kernel_supported(MedianKernel::AVX512))
+    {
+        median_Parallel_mt(psrc, pdst, len, threads);
+    }
+    else if (median_kernel_supported(MedianKernel::AVX2))
+    {
+        median_Parallel_avx2(psrc, pdst, len);
+    }
+    else
+    {
+        median_Cpp(psrc, pdst, len);
+    }
+}
+
+}   // namespace
+
+int main(int argc, char** argv)
+{
+    bool            int16 = false;
+    size_t          threads = 0;
+    const char*     paths[2] = {};
+    int             npaths = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--int16") == 0)
+        {
+            int16 = true;
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (argv[i][0] != '-' && npaths < 2)
+        {
+            paths[npaths++] = argv[i];
+        }
+        else
+        {
+            usage();
+        }
+    }
+    if (npaths != 2)
+    {
+        usage();
+    }
+
+    size_t const    sample_size = int16 ? sizeof(int16_t) : sizeof(float);
+    int const       in_fd = open(paths[0], O_RDONLY);
+    struct stat     in_stat;
+
+    if (in_fd < 0 || fstat(in_fd, &in_stat) != 0)
+    {
+        fail("cannot open", paths[0]);
+    }
+    if ((size_t)in_stat.st_size % sample_size != 0)
+    {
+        std::fprintf(stderr, "median-file: '%s' is not a whole number of samples\n", paths[0]);
+        return 1;
+    }
+
+    size_t const    bytes = (size_t)in_stat.st_size;
+    size_t const    len = bytes / sample_size;
+
+    //- Preallocate the output, so that writing through the mapping cannot hit a full disk.
+    //
+    int const       out_fd = open(paths[1], O_RDWR | O_CREAT, 0644);
+    struct stat     out_stat;
+
+    if (out_fd < 0 || fstat(out_fd, &out_stat) != 0)
+    {
+        fail("cannot open", paths[1]);
+    }
+    if ((size_t)out_stat.st_size != bytes)
+    {
+        if (ftruncate(out_fd, (off_t)bytes) != 0)
+        {
+            fail("cannot resize", paths[1]);
+        }
+        if (int error = posix_fallocate(out_fd, 0, (off_t)bytes); error != 0 && error != EOPNOTSUPP)
+        {
+            errno = error;
+            fail("cannot preallocate", paths[1]);
+        }
+    }
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    Mapping     in;
+    Mapping     out;
+
+    in.size = out.size = bytes;
+    in.data = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, in_fd, 0);
+    if (in.data == MAP_FAILED)
+    {
+        fail("cannot map", paths[0]);
+    }
+    out.data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+    if (out.data == MAP_FAILED)
+    {
+        fail("cannot map", paths[1]);
+    }
+    advise(in);
+    advise(out);
+
+    struct rusage   before;
+    struct rusage   after;
+
+    getrusage(RUSAGE_SELF, &before);
+    auto const      start = std::chrono::steady_clock::now();
+
+    if (int16)
+    {
+        filter_int16((const int16_t*)in.data, (int16_t*)out.data, len, threads);
+    }
+    else
+    {
+        filter_float((const float*)in.data, (float*)out.data, len, threads);
+    }
+
+    std::chrono::duration<double> const     elapsed = std::chrono::steady_clock::now() - start;
+
+    getrusage(RUSAGE_SELF, &after);
+
+    std::printf("%zu samples (%.1f MB) in %.3f s: %.1f MB/s, %.1f Msamples/s\n",
+                len, bytes / 1e6, elapsed.count(), bytes / 1e6 / elapsed.count(), len / 1e6 / elapsed.count());
+    std::printf("page faults: %ld minor, %ld major\n",
+                after.ru_minflt - before.ru_minflt, after.ru_majflt - before.ru_majflt);
+
+    close(in_fd);
+    close(out_fd);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "avx-median.h"
+#include "selection_network.h"
+
+#include <utility>
+
+//- Median of a (2 * Radius + 1)-tap window for 16 consecutive outputs at once. Each tap of the
+//  window is one register, and the selection network runs vertically across the registers, so
+//  every lane computes the median for its own output position.
+//
+template<int Radius, int... I>
+KEWB_FORCE_INLINE
+static rf512 process16(rf512 prev, rf512 curr, rf512 next, std::integer_sequence<int, I...>)
+{
+    using median_network = selection_network<2 * Radius + 1, Radius>;
+
+    rf512   s[] = { window_tap<I - Radius>(prev, curr, next)... };
+
+    apply_network<median_network>(s);
+    return s[Radius];
+}
+
+template<int Radius>
+KEWB_FORCE_INLINE
+static rf512 process16(rf512 prev, rf512 curr, rf512 next)
+{
+    return process16<Radius>(prev, curr, next, std::make_integer_sequence<int, 2 * Radius + 1>());
+}
+
+template<int Radius>
+void median_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+    static_assert(Radius >= 1 && Radius <= 15, "the window must fit into 'prev | curr | next'");
+
+    __m512      prev;   //- Bottom of the input data window
+    __m512      curr;   //- Middle of the input data window
+    __m512      next;   //- Top of the input data window
+    m512        mask;   //- Trailing boundary mask
+    __m512      data;   //- Holds output prior to store operation
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    rf512 const     first = load_value(psrc[0]);
+    rf512 const     last = load_value(psrc[buf_len - 1]);
+
+    //- Preload the initial input data window; note the values in the register representing
+    //  data preceding the input array are equal to the first element.
+    //
+
+    if (buf_len < 16)
+    {
+        prev = first;
+        mask = ~(0xffffffff << buf_len);
+        curr = masked_load_from(psrc, last, mask);
+        next = last;
+
+        data = process16<Radius>(prev, curr, next);
+        masked_store_to(pdst, data, mask);
+    }
+    else
+    {
+        size_t  read = 0;
+        size_t  used = 0;
+        size_t  wrote = 0;
+
+        curr = first;
+        next = load_from(psrc);
+        read += 16;
+        used += 16;
+
+        while (used < (buf_len + 16))
+        {
+            prev = curr;
+            curr = next;
+
+            if (read <= (buf_len - 16))
+            {
+                next = load_from(psrc + read);
+                read += 16;
+            }
+            else
+            {
+                mask = ~(0xffffffff << (buf_len - read));
+                next = masked_load_from(psrc + read, last, mask);
+                read = buf_len;
+            }
+            used += 16;
+
+            data = process16<Radius>(prev, curr, next);
+
+            if (wrote <= (buf_len - 16))
+            {
+                store_to_address(pdst + wrote, data);
+                wrote += 16;
+            }
+            else
+            {
+                mask = ~(0xffffffff << (buf_len - wrote));
+                masked_store_to(pdst + wrote, data, mask);
+                wrote = buf_len;
+            }
+        }
+    }
+}
+
+template void median_filter<1>(const float*, float*, size_t);
+template void median_filter<2>(const float*, float*, size_t);
+template void median_filter<3>(const float*, float*, size_t);
+template void median_filter<4>(const float*, float*, size_t);
+template void median_filter<5>(const float*, float*, size_t);
+template void median_filter<6>(const float*, float*, size_t);
+template void median_filter<7>(const float*, float*, size_t);
+template void median_filter<8>(const float*, float*, size_t);
+template void median_filter<9>(const float*, float*, size_t);
+template void median_filter<10>(const float*, float*, size_t);
+template void median_filter<11>(const float*, float*, size_t);
+template void median_filter<12>(const float*, float*, size_t);
@@ -0,0 +1,131 @@
+#include "avx-median.h"
+#include "selection_network.h"
+
+#include <algorithm>
+#include <utility>
+
+//- 2D median over a (2 * Radius + 1) square window for 16 consecutive pixels of a row at once.
+//
+//  For every block of 16 columns, the 2 * Radius + 1 rows of the window are loaded into registers
+//  and sorted vertically, so register k holds the k-th smallest sample of each column. A sorted
+//  block is used by the outputs of three blocks (as 'next', 'curr' and 'prev'), and the window of
+//  every output is assembled out of the sorted columns with 'window_tap'. Because the columns
+//  arrive sorted, the median only needs the much smaller sorted_columns_median_network instead
+//  of a selection over all (2 * Radius + 1)^2 samples.
+//
+//  The image is processed in vertical strips of 'strip_width' columns, top to bottom, so the rows
+//  of the window stay cached between consecutive output rows even for 4K frames.
+//
+static constexpr size_t     strip_width = 512;
+
+//- Loads the 16 samples starting at column 'x' of every row of the window and sorts them by
+//  column. Columns left or right of the image replicate the edge.
+//
+template<int Radius, size_t... K>
+KEWB_FORCE_INLINE
+static void load_sorted_columns(const float* const* rows, ptrdiff_t x, size_t width, rf512* cols, std::index_sequence<K...>)
+{
+    if (x >= 0 && (size_t)x + 16 <= width)
+    {
+        ((cols[K] = load_from(rows[K] + x)), ...);
+    }
+    else if (x < 0)
+    {
+        ((cols[K] = load_value(rows[K][0])), ...);
+    }
+    else if ((size_t)x < width)
+    {
+        m512 const  mask = ~(0xffffffff << (width - x));
+
+        ((cols[K] = masked_load_from(rows[K] + x, load_value(rows[K][width - 1]), mask)), ...);
+    }
+    else
+    {
+        ((cols[K] = load_value(rows[K][width - 1])), ...);
+    }
+    apply_network<sorting_network<sizeof...(K)>>(cols);
+}
+
+template<int Radius>
+KEWB_FORCE_INLINE
+static void load_sorted_columns(const float* const* rows, ptrdiff_t x, size_t width, rf512* cols)
+{
+    load_sorted_columns<Radius>(rows, x, width, cols, std::make_index_sequence<2 * Radius + 1>());
+}
+
+template<size_t... K>
+KEWB_FORCE_INLINE
+static void shift_blocks(rf512* prev, rf512* curr, rf512 const* next, std::index_sequence<K...>)
+{
+    ((prev[K] = curr[K], curr[K] = next[K]), ...);
+}
+
+template<int Radius, size_t... I>
+KEWB_FORCE_INLINE
+static rf512 process16(rf512 const* prev, rf512 const* curr, rf512 const* next, std::index_sequence<I...>)
+{
+    constexpr size_t    C = 2 * Radius + 1;
+
+    using median_network = sorted_columns_median_network<C>;
+
+    //- Input 'c * C + k' is the k-th smallest sample of the column at offset 'c - Radius'.
+    //
+    rf512   s[] = { window_tap<(int)(I / C) - Radius>(prev[I % C], curr[I % C], next[I % C])... };
+
+    apply_network<median_network>(s);
+    return s[median_network::output];
+}
+
+template<int Radius>
+void median_filter_2d(const float* psrc, size_t src_stride, float* pdst, size_t dst_stride, size_t width, size_t height)
+{
+    static_assert(Radius >= 1 && Radius <= 3, "");
+
+    constexpr size_t    C = 2 * Radius + 1;
+
+    rf512           prev[C];    //- Sorted columns left of the current block
+    rf512           curr[C];    //- Sorted columns of the current block
+    rf512           next[C];    //- Sorted columns right of the current block
+    rf512           data;       //- Holds output prior to store operation
+    float const*    rows[C];    //- Input rows of the window, replicated at the top and bottom
+
+    for (size_t x0 = 0; x0 < width; x0 += strip_width)
+    {
+        size_t const    x1 = std::min(x0 + strip_width, width);
+
+        for (size_t y = 0; y < height; ++y)
+        {
+            float* const    out = pdst + y * dst_stride;
+
+            for (size_t k = 0; k < C; ++k)
+            {
+                rows[k] = psrc + std::clamp<ptrdiff_t>((ptrdiff_t)(y + k) - Radius, 0, (ptrdiff_t)height - 1) * src_stride;
+            }
+
+            load_sorted_columns<Radius>(rows, (ptrdiff_t)x0 - 16, width, prev);
+            load_sorted_columns<Radius>(rows, (ptrdiff_t)x0, width, curr);
+
+            for (size_t x = x0; x < x1; x += 16)
+            {
+                load_sorted_columns<Radius>(rows, (ptrdiff_t)x + 16, width, next);
+
+                data = process16<Radius>(prev, curr, next, std::make_index_sequence<C * C>());
+
+                if (x + 16 <= width)
+                {
+                    store_to_address(out + x, data);
+                }
+                else
+                {
+                    masked_store_to(out + x, data, ~(0xffffffff << (width - x)));
+                }
+
+                shift_blocks(prev, curr, next, std::make_index_sequence<C>());
+            }
+        }
+    }
+}
+
+template void median_filter_2d<1>(const float*, size_t, float*, size_t, size_t, size_t);
+template void median_filter_2d<2>(const float*, size_t, float*, size_t, size_t, size_t);
+template void median_filter_2d<3>(const float*, size_t, float*, size_t, size_t, size_t);
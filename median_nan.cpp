@@ -0,0 +1,229 @@
+#include "avx-median.h"
+#include "output_writer.h"
+
+#include <limits>
+
+//- median_Parallel for inputs that may hold NaN. min/max return their second operand when either
+//  is NaN, so the plain network gives order-dependent results on NaN windows; each policy below
+//  either keeps NaN out of the network or overrides the lanes it reaches.
+//
+namespace
+{
+
+KEWB_FORCE_INLINE m512
+    nan_lanes(rf512 value)
+{
+    return _mm512_cmp_ps_mask(value, value, _CMP_UNORD_Q);
+}
+
+KEWB_FORCE_INLINE rf512
+    nan_to_infinity(rf512 value)
+{
+    return _mm512_mask_mov_ps(value, (__mmask16)nan_lanes(value),
+                              _mm512_set1_ps(std::numeric_limits<float>::infinity()));
+}
+
+KEWB_FORCE_INLINE void
+    sort(rf512& l, rf512& r)
+{
+    rf512 tmp = minimum(l, r);
+    r = maximum(l, r);
+    l = tmp;
+}
+
+//- The network of median_Parallel, over the window of 7 taps centred on each lane of 'curr'.
+//
+KEWB_FORCE_INLINE rf512
+    median_of_7(rf512 prev, rf512 curr, rf512 next)
+{
+    rf512 s1 = window_tap<-3>(prev, curr, next);
+    rf512 s2 = window_tap<-2>(prev, curr, next);
+    rf512 s3 = window_tap<-1>(prev, curr, next);
+    rf512 s4 = curr;
+    rf512 s5 = window_tap<1>(prev, curr, next);
+    rf512 s6 = window_tap<2>(prev, curr, next);
+    rf512 s7 = window_tap<3>(prev, curr, next);
+    sort(s2, s3); sort(s4, s5); sort(s6, s7);
+    sort(s1, s3); sort(s5, s7); sort(s4, s6);
+    s3 = minimum(s3, s7); sort(s2, s6); sort(s1, s5);
+    s3 = minimum(s3, s6); s4 = maximum(s4, s1);
+    s3 = minimum(s3, s5); s4 = maximum(s2, s4);
+    s4 = maximum(s3, s4);
+    return s4;
+}
+
+//- Lanes of 'curr' whose window holds a NaN: the NaN lanes of the 48 samples, smeared over 7
+//  positions and realigned so that bit i covers samples i - 3 .. i + 3 of 'curr'.
+//
+KEWB_FORCE_INLINE m512
+    nan_windows(rf512 prev, rf512 curr, rf512 next)
+{
+    uint64_t    nans = (uint64_t)nan_lanes(prev) | (uint64_t)nan_lanes(curr) << 16 | (uint64_t)nan_lanes(next) << 32;
+
+    nans |= nans >> 1;
+    nans |= nans >> 2;
+    nans |= nans >> 3;
+    return (m512)(nans >> 13) & 0xFFFFu;
+}
+
+KEWB_FORCE_INLINE __mmask16
+    at_most(rf512 counts, float count)
+{
+    return _mm512_cmp_ps_mask(counts, _mm512_set1_ps(count), _CMP_LE_OQ);
+}
+
+//- Median of the non-NaN samples of each window. With NaN sorted to the top as +Inf, the 'k'
+//  valid samples are ranks 0 .. k - 1 of the window. The 15-comparator network below does not
+//  sort it: only ranks 0 .. 4 are guaranteed in place, and ranks 5 and 6 may be swapped. That is
+//  enough, since only ranks 0 .. 3 are ever selected. An even 'k' averages the two middle ranks,
+//  and an all-NaN window gives NaN.
+//
+KEWB_FORCE_INLINE rf512
+    median_of_valid(rf512 prev, rf512 curr, rf512 next)
+{
+    rf512 const     one = _mm512_set1_ps(1.0f);
+    rf512 const     half = _mm512_set1_ps(0.5f);
+    rf512 const     nan_prev = _mm512_maskz_mov_ps((__mmask16)nan_lanes(prev), one);
+    rf512 const     nan_curr = _mm512_maskz_mov_ps((__mmask16)nan_lanes(curr), one);
+    rf512 const     nan_next = _mm512_maskz_mov_ps((__mmask16)nan_lanes(next), one);
+
+    rf512   nans = _mm512_add_ps(window_tap<-3>(nan_prev, nan_curr, nan_next), window_tap<-2>(nan_prev, nan_curr, nan_next));
+    nans = _mm512_add_ps(nans, window_tap<-1>(nan_prev, nan_curr, nan_next));
+    nans = _mm512_add_ps(nans, nan_curr);
+    nans = _mm512_add_ps(nans, window_tap<1>(nan_prev, nan_curr, nan_next));
+    nans = _mm512_add_ps(nans, window_tap<2>(nan_prev, nan_curr, nan_next));
+    nans = _mm512_add_ps(nans, window_tap<3>(nan_prev, nan_curr, nan_next));
+
+    prev = nan_to_infinity(prev);
+    curr = nan_to_infinity(curr);
+    next = nan_to_infinity(next);
+
+    rf512 s0 = window_tap<-3>(prev, curr, next);
+    rf512 s1 = window_tap<-2>(prev, curr, next);
+    rf512 s2 = window_tap<-1>(prev, curr, next);
+    rf512 s3 = curr;
+    rf512 s4 = window_tap<1>(prev, curr, next);
+    rf512 s5 = window_tap<2>(prev, curr, next);
+    rf512 s6 = window_tap<3>(prev, curr, next);
+    sort(s0, s6); sort(s2, s3); sort(s4, s5);
+    sort(s0, s2); sort(s1, s4); sort(s3, s6);
+    sort(s0, s1); sort(s2, s5); sort(s3, s4);
+    sort(s1, s2); sort(s4, s6);
+    sort(s2, s3); sort(s4, s5);
+    sort(s1, s2); sort(s3, s4);
+
+    //- Valid samples: 'k' = 7 - nans; the lower middle is rank (k - 1) / 2, the upper k / 2.
+    //
+    rf512   lower = _mm512_mask_mov_ps(s0, at_most(nans, 4.0f), s1);
+    lower = _mm512_mask_mov_ps(lower, at_most(nans, 2.0f), s2);
+    lower = _mm512_mask_mov_ps(lower, at_most(nans, 0.0f), s3);
+
+    rf512   upper = _mm512_mask_mov_ps(s0, at_most(nans, 5.0f), s1);
+    upper = _mm512_mask_mov_ps(upper, at_most(nans, 3.0f), s2);
+    upper = _mm512_mask_mov_ps(upper, at_most(nans, 1.0f), s3);
+
+    //- The mean is taken as lower / 2 + upper / 2, so that it cannot overflow; an odd 'k' has
+    //  lower == upper and takes the sample itself.
+    //
+    rf512   data = _mm512_fmadd_ps(lower, half, _mm512_mul_ps(upper, half));
+    data = _mm512_mask_mov_ps(data, (__mmask16)_mm512_cmp_ps_mask(lower, upper, _CMP_EQ_OQ), lower);
+    return _mm512_mask_mov_ps(data, (__mmask16)_mm512_cmp_ps_mask(nans, _mm512_set1_ps(7.0f), _CMP_EQ_OQ),
+                              _mm512_set1_ps(std::numeric_limits<float>::quiet_NaN()));
+}
+
+template<NanPolicy Policy>
+KEWB_FORCE_INLINE rf512
+    filter_block(rf512 prev, rf512 curr, rf512 next)
+{
+    if constexpr (Policy == NanPolicy::Propagate)
+    {
+        return _mm512_mask_mov_ps(median_of_7(prev, curr, next), (__mmask16)nan_windows(prev, curr, next),
+                                  _mm512_set1_ps(std::numeric_limits<float>::quiet_NaN()));
+    }
+    else if constexpr (Policy == NanPolicy::Ignore)
+    {
+        //- Dropouts are rare, so blocks without NaN skip the counting and the full sort.
+        //
+        if ((nan_lanes(prev) | nan_lanes(curr) | nan_lanes(next)) == 0)
+        {
+            return median_of_7(prev, curr, next);
+        }
+        return median_of_valid(prev, curr, next);
+    }
+    else
+    {
+        return median_of_7(nan_to_infinity(prev), nan_to_infinity(curr), nan_to_infinity(next));
+    }
+}
+
+}   // namespace
+
+template<NanPolicy Policy>
+void median_Parallel(const float* psrc, float* pdst, size_t buf_len)
+{
+    __m512      prev;   //- Bottom of the input data window
+    __m512      curr;   //- Middle of the input data window
+    __m512      next;   //- Top of the input data window
+    __m512      data;   //- Holds output prior to store operation
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    CachedWriter    out(pdst);
+    rf512 const     first = load_value(psrc[0]);
+    rf512 const     last = load_value(psrc[buf_len - 1]);
+
+    //- Same loop as median_Parallel; the window around each block of 16 outputs is passed to
+    //  the policy as is, NaN included.
+    //
+    if (buf_len < 16)
+    {
+        curr = masked_load_from(psrc, last, ~(0xffffffff << buf_len));
+        data = filter_block<Policy>(first, curr, last);
+        out.put_last(data, buf_len);
+    }
+    else
+    {
+        size_t  read = 16;
+        size_t  wrote = 0;
+
+        curr = first;
+        next = load_from(psrc);
+
+        while (wrote < buf_len)
+        {
+            prev = curr;
+            curr = next;
+
+            if (read <= (buf_len - 16))
+            {
+                next = load_from(psrc + read);
+                read += 16;
+            }
+            else
+            {
+                next = masked_load_from(psrc + read, last, ~(0xffffffff << (buf_len - read)));
+                read = buf_len;
+            }
+
+            data = filter_block<Policy>(prev, curr, next);
+
+            if (wrote < (buf_len - 16))
+            {
+                out.put(data);
+                wrote += 16;
+            }
+            else
+            {
+                out.put_last(data, buf_len - wrote);
+                wrote = buf_len;
+            }
+        }
+    }
+}
+
+template void median_Parallel<NanPolicy::Propagate>(const float*, float*, size_t);
+template void median_Parallel<NanPolicy::Ignore>(const float*, float*, size_t);
+template void median_Parallel<NanPolicy::AsInfinity>(const float*, float*, size_t);
@@ -0,0 +1,78 @@
+#include "avx-median.h"
+#include "median_stream.h"
+
+#include <algorithm>
+
+//- Filters the outputs from the first not yet emitted one up to stream position 'end' out of a
+//  stitch buffer that starts with the carried tail, and writes them to 'pdst'.
+//
+size_t MedianStream::emit(const float* pstitch, size_t end, bool trail_halo, float* pdst)
+{
+    size_t const    base = m_total - m_tail_len;            //- Stream position of 'pstitch[0]'
+    size_t const    emitted = (m_total > 3) ? m_total - 3 : 0;
+    size_t const    start = (base == 0) ? 0 : 3;            //- Leading halo unless at stream start
+    float           work[16];
+
+    if (end <= emitted)
+    {
+        return 0;
+    }
+
+    median_Parallel_chunk(pstitch + start, work, end - base - start, start != 0, trail_halo, false);
+    std::copy(work + (emitted - base - start), work + (end - base - start), pdst);
+    return end - emitted;
+}
+
+size_t MedianStream::push(const float* psrc, size_t len, float* pdst)
+{
+    float       stitch[12];
+    size_t      wrote;
+
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    //- Outputs whose window reaches back into the carried tail.
+    //
+    std::copy_n(m_tail, m_tail_len, stitch);
+    std::copy_n(psrc, std::min<size_t>(len, 6), stitch + m_tail_len);
+    wrote = emit(stitch, std::min(m_total + 3, std::max<size_t>(m_total + len, 3) - 3), true, pdst);
+
+    //- Outputs whose window lies entirely within the new chunk.
+    //
+    if (len > 6)
+    {
+        median_Parallel_chunk(psrc + 3, pdst + wrote, len - 6, true, true, false);
+        wrote += len - 6;
+    }
+
+    //- Carry the last 6 samples of the stream into the next call.
+    //
+    size_t const    keep = std::min<size_t>(m_tail_len + len, 6);
+
+    if (len >= keep)
+    {
+        std::copy_n(psrc + len - keep, keep, m_tail);
+    }
+    else
+    {
+        std::copy_n(stitch + m_tail_len + len - keep, keep, m_tail);
+    }
+    m_tail_len = keep;
+    m_total += len;
+    return wrote;
+}
+
+size_t MedianStream::flush(float* pdst)
+{
+    size_t  wrote = 0;
+
+    if (m_total != 0)
+    {
+        wrote = emit(m_tail, m_total, false, pdst);
+    }
+    m_tail_len = 0;
+    m_total = 0;
+    return wrote;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+//- Incremental 7-tap median over a stream that arrives in pieces. Output lags input by exactly
+//  3 samples: after 'T' samples have been pushed, outputs '0 .. T - 4' have been emitted. The
+//  last 3 outputs are emitted by 'flush', which applies the trailing edge replication. The
+//  concatenated output is bit-exact with median_Parallel over the concatenated input.
+//
+//  The bulk of every pushed chunk is filtered in place by median_Parallel_chunk, using the chunk's
+//  own samples as halos; only the outputs around each seam go through the 12-sample stitch
+//  buffer built from the carried tail of the previous chunk.
+//
+class MedianStream
+{
+public:
+    //- Filters 'len' more samples; writes the newly available outputs to 'pdst' (at most 'len')
+    //  and returns their number.
+    //
+    size_t  push(const float* psrc, size_t len, float* pdst);
+
+    //- Ends the stream; writes the remaining outputs (at most 3) to 'pdst', returns their number
+    //  and resets the stream so it can be reused.
+    //
+    size_t  flush(float* pdst);
+
+private:
+    size_t  emit(const float* pstitch, size_t end, bool trail_halo, float* pdst);
+
+    float   m_tail[6];          //- Last min(m_total, 6) input samples
+    size_t  m_tail_len = 0;
+    size_t  m_total = 0;        //- Samples pushed so far
+};
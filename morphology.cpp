@@ -0,0 +1,319 @@
+#include "avx-median.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+//- Rolling minimum and maximum after van Herk and Gil-Werman. The (extended) input is cut into
+//  blocks of W = 2 * radius + 1 samples; 'g' holds the running extremum from the start of each
+//  block and 'h' the running extremum to its end. Any window of W samples spans at most two
+//  blocks, so the extremum of the window starting at 'j' is op(h[j], g[j + W - 1]), whatever W.
+//
+//  The scans run 16 samples at a time: an in-register prefix (or suffix) scan of 4 shifts, which
+//  stops at the block boundaries inside the register, followed by the carry of the extremum from
+//  the register before (or after) into the lanes whose block began (or ends) outside it.
+//
+//  The signal is filtered in tiles of at least 'tile_size' outputs, so that 'g' and 'h' stay in
+//  cache; the fused opening and closing run both of their passes over a tile before moving on.
+//
+namespace
+{
+
+constexpr size_t    tile_size = 2048;
+
+template<bool Max>
+KEWB_FORCE_INLINE rf512
+    extremum(rf512 a, rf512 b)
+{
+    if constexpr (Max)
+    {
+        return maximum(a, b);
+    }
+    else
+    {
+        return minimum(a, b);
+    }
+}
+
+template<bool Max>
+KEWB_FORCE_INLINE rf512
+    masked_extremum(rf512 a, __mmask16 mask, rf512 b)
+{
+    if constexpr (Max)
+    {
+        return _mm512_mask_max_ps(a, mask, a, b);
+    }
+    else
+    {
+        return _mm512_mask_min_ps(a, mask, a, b);
+    }
+}
+
+template<bool Max>
+constexpr float     identity = Max ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+
+KEWB_FORCE_INLINE ri512
+    lane_indices()
+{
+    return load_values<0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15>();
+}
+
+template<int K>
+KEWB_FORCE_INLINE __mmask16
+    at_least(ri512 values)
+{
+    return _mm512_cmpge_epi32_mask(values, _mm512_set1_epi32(K));
+}
+
+//- The lanes of each register that take part in the steps of the scans. Blocks start at sample
+//  0 of every tile, so the masks only depend on the position in the tile and are computed once.
+//
+struct ScanMasks
+{
+    __mmask16   forward[5];     //- Lanes taking lane i - 1, i - 2, i - 4, i - 8, then the carry
+    __mmask16   backward[5];    //- Lanes taking lane i + 1, i + 2, i + 4, i + 8, then the carry
+};
+
+std::vector<ScanMasks> make_scan_masks(size_t len, size_t window)
+{
+    std::vector<ScanMasks>  masks((len + 15) / 16);
+    ri512 const             lanes = lane_indices();
+    ri512 const             reverse_lanes = _mm512_sub_epi32(_mm512_set1_epi32(15), lanes);
+    ri512 const             step = _mm512_set1_epi32((int32_t)(16 % window));
+    ri512 const             wrap = _mm512_set1_epi32((int32_t)window);
+    ri512 const             last = _mm512_set1_epi32((int32_t)window - 1);
+    int32_t                 first[16];
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        first[i] = (int32_t)(i % window);
+    }
+
+    ri512   offset = _mm512_loadu_si512(first);
+
+    for (ScanMasks& m : masks)
+    {
+        ri512 const     distance = _mm512_sub_epi32(last, offset);
+
+        m.forward[0] = at_least<1>(offset) & 0xFFFEu;
+        m.forward[1] = at_least<2>(offset) & 0xFFFCu;
+        m.forward[2] = at_least<4>(offset) & 0xFFF0u;
+        m.forward[3] = at_least<8>(offset) & 0xFF00u;
+        m.forward[4] = _mm512_cmpgt_epi32_mask(offset, lanes);
+        m.backward[0] = at_least<1>(distance) & 0x7FFFu;
+        m.backward[1] = at_least<2>(distance) & 0x3FFFu;
+        m.backward[2] = at_least<4>(distance) & 0x0FFFu;
+        m.backward[3] = at_least<8>(distance) & 0x00FFu;
+        m.backward[4] = _mm512_cmpgt_epi32_mask(distance, reverse_lanes);
+
+        offset = _mm512_add_epi32(offset, step);
+        offset = _mm512_mask_sub_epi32(offset, _mm512_cmpge_epi32_mask(offset, wrap), offset, wrap);
+    }
+    return masks;
+}
+
+//- Scratch for the tiles of one call: 'outputs' per tile, plus up to 4 * radius samples of halo.
+//
+struct Tile
+{
+    explicit Tile(size_t window)
+    :   window(window),
+        outputs(std::max(tile_size, 4 * window)),
+        size((outputs + 2 * window + 15) / 16 * 16 + 16),
+        masks(make_scan_masks(size, window)),
+        x(size), g(size), h(size), m(size)
+    {}
+
+    size_t                  window;
+    size_t                  outputs;
+    size_t                  size;
+    std::vector<ScanMasks>  masks;
+    std::vector<float>      x;  //- Replicated input at the edges
+    std::vector<float>      g;  //- Extremum from the start of each block
+    std::vector<float>      h;  //- Extremum to the end of each block
+    std::vector<float>      m;  //- First pass of a fused opening or closing
+};
+
+//- 'g' and 'h' over the 'len' samples at 'px'; both are written for 'len' rounded up to 16.
+//
+template<bool Max>
+void scan_blocks(const float* px, size_t len, Tile& tile)
+{
+    rf512 const         fill = load_value(identity<Max>);
+    size_t const        blocks = (len + 15) / 16;
+    ScanMasks const*    masks = tile.masks.data();
+    float* const        g = tile.g.data();
+    float* const        h = tile.h.data();
+
+    //- Forward: lane i takes lane i - k where that is in the same block.
+    //
+    rf512   carry = fill;
+
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        size_t const    pos = 16 * b;
+        rf512           data = (pos + 16 <= len) ? load_from(px + pos)
+                                                 : masked_load_from(px + pos, fill, ~(0xffffffff << (len - pos)));
+
+        data = masked_extremum<Max>(data, masks[b].forward[0], rotate_up<1>(data));
+        data = masked_extremum<Max>(data, masks[b].forward[1], rotate_up<2>(data));
+        data = masked_extremum<Max>(data, masks[b].forward[2], rotate_up<4>(data));
+        data = masked_extremum<Max>(data, masks[b].forward[3], rotate_up<8>(data));
+        data = masked_extremum<Max>(data, masks[b].forward[4], carry);
+        store_to_address(g + pos, data);
+        carry = permute(data, _mm512_set1_epi32(15));
+    }
+
+    //- Backward: lane i takes lane i + k where that is in the same block.
+    //
+    carry = fill;
+
+    for (size_t b = blocks; b-- > 0;)
+    {
+        size_t const    pos = 16 * b;
+        rf512           data = (pos + 16 <= len) ? load_from(px + pos)
+                                                 : masked_load_from(px + pos, fill, ~(0xffffffff << (len - pos)));
+
+        data = masked_extremum<Max>(data, masks[b].backward[0], rotate<-1>(data));
+        data = masked_extremum<Max>(data, masks[b].backward[1], rotate<-2>(data));
+        data = masked_extremum<Max>(data, masks[b].backward[2], rotate<-4>(data));
+        data = masked_extremum<Max>(data, masks[b].backward[3], rotate<-8>(data));
+        data = masked_extremum<Max>(data, masks[b].backward[4], carry);
+        store_to_address(h + pos, data);
+        carry = permute(data, _mm512_setzero_si512());
+    }
+}
+
+//- 'count' outputs from the 'count + window - 1' samples at 'px'.
+//
+template<bool Max>
+void filter_tile(const float* px, float* pdst, size_t count, Tile& tile)
+{
+    size_t const    span = tile.window - 1;
+    float* const    g = tile.g.data();
+    float* const    h = tile.h.data();
+
+    scan_blocks<Max>(px, count + span, tile);
+
+    size_t  pos = 0;
+
+    for (; pos + 16 <= count; pos += 16)
+    {
+        store_to_address(pdst + pos, extremum<Max>(load_from(h + pos), load_from(g + pos + span)));
+    }
+    if (pos < count)
+    {
+        masked_store_to(pdst + pos, extremum<Max>(load_from(h + pos), load_from(g + pos + span)),
+                        ~(0xffffffff << (count - pos)));
+    }
+}
+
+//- Samples 'begin' .. 'begin + count - 1' of the input with its edges replicated; a pointer into
+//  'psrc' where no replication is needed, a copy in 'scratch' otherwise.
+//
+const float* extended(const float* psrc, size_t len, ptrdiff_t begin, size_t count, float* scratch)
+{
+    if (begin >= 0 && begin + (ptrdiff_t)count <= (ptrdiff_t)len)
+    {
+        return psrc + begin;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        scratch[i] = psrc[std::clamp<ptrdiff_t>(begin + (ptrdiff_t)i, 0, (ptrdiff_t)len - 1)];
+    }
+    return scratch;
+}
+
+template<bool Max>
+void extremum_filter(const float* psrc, float* pdst, size_t buf_len, size_t window)
+{
+    size_t const    radius = window / 2;
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+    if (radius == 0)
+    {
+        std::copy_n(psrc, buf_len, pdst);
+        return;
+    }
+
+    Tile    tile(2 * radius + 1);
+
+    for (size_t pos = 0; pos < buf_len; pos += tile.outputs)
+    {
+        size_t const    count = std::min(tile.outputs, buf_len - pos);
+        const float*    px = extended(psrc, buf_len, (ptrdiff_t)pos - (ptrdiff_t)radius, count + 2 * radius, tile.x.data());
+
+        filter_tile<Max>(px, pdst + pos, count, tile);
+    }
+}
+
+//- Opening (Max = true: erosion, then dilation) or closing (the reverse). The first pass covers
+//  the tile plus 'radius' samples on either side; the positions of the first pass outside the
+//  signal then take its edge values, as replicating the output of a separate first pass would.
+//
+template<bool Max>
+void fused_filter(const float* psrc, float* pdst, size_t buf_len, size_t window)
+{
+    size_t const    radius = window / 2;
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+    if (radius == 0)
+    {
+        std::copy_n(psrc, buf_len, pdst);
+        return;
+    }
+
+    Tile    tile(2 * radius + 1);
+
+    for (size_t pos = 0; pos < buf_len; pos += tile.outputs)
+    {
+        size_t const        count = std::min(tile.outputs, buf_len - pos);
+        ptrdiff_t const     begin = (ptrdiff_t)pos - (ptrdiff_t)radius;
+        size_t const        inner = count + 2 * radius;
+        const float*        px = extended(psrc, buf_len, begin - (ptrdiff_t)radius, inner + 2 * radius, tile.x.data());
+        float* const        pm = tile.m.data();
+
+        filter_tile<!Max>(px, pm, inner, tile);
+
+        if (begin < 0)
+        {
+            std::fill_n(pm, (size_t)-begin, pm[-begin]);
+        }
+        if (begin + (ptrdiff_t)inner > (ptrdiff_t)buf_len)
+        {
+            size_t const    last = buf_len - 1 - (size_t)begin;
+
+            std::fill(pm + last + 1, pm + inner, pm[last]);
+        }
+
+        filter_tile<Max>(pm, pdst + pos, count, tile);
+    }
+}
+
+}   // namespace
+
+void min_filter(const float* psrc, float* pdst, size_t buf_len, size_t window)
+{
+    extremum_filter<false>(psrc, pdst, buf_len, window);
+}
+
+void max_filter(const float* psrc, float* pdst, size_t buf_len, size_t window)
+{
+    extremum_filter<true>(psrc, pdst, buf_len, window);
+}
+
+void opening_filter(const float* psrc, float* pdst, size_t buf_len, size_t window)
+{
+    fused_filter<true>(psrc, pdst, buf_len, window);
+}
+
+void closing_filter(const float* psrc, float* pdst, size_t buf_len, size_t window)
+{
+    fused_filter<false>(psrc, pdst, buf_len, window);
+}
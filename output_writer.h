@@ -0,0 +1,197 @@
+#pragma once
+
+#include "avx-median.h"
+
+#include <algorithm>
+
+//- The 16-sample block at 'pos' of a buffer of 'buf_len' samples, for kernels that step through
+//  it in whole blocks and run past its end: lanes at or beyond 'buf_len' read as 'last' and are
+//  not written.
+//
+KEWB_FORCE_INLINE rf512
+    load_clamped(const float* psrc, size_t pos, size_t buf_len, rf512 last)
+{
+    if (pos + 16 <= buf_len)
+    {
+        return load_from(psrc + pos);
+    }
+    if (pos < buf_len)
+    {
+        return masked_load_from(psrc + pos, last, ~(0xffffffff << (buf_len - pos)));
+    }
+    return last;
+}
+
+KEWB_FORCE_INLINE void
+    store_clamped(float* pdst, size_t pos, size_t buf_len, rf512 data)
+{
+    if (pos + 16 <= buf_len)
+    {
+        store_to_address(pdst + pos, data);
+    }
+    else if (pos < buf_len)
+    {
+        masked_store_to(pdst + pos, data, ~(0xffffffff << (buf_len - pos)));
+    }
+}
+
+//- Output policies for the 16-lane float kernels. Consecutive 16-sample blocks of output are
+//  passed to put(); the final, possibly partial or empty, block to put_last(), exactly once.
+//
+class CachedWriter
+{
+public:
+    explicit CachedWriter(float* pdst)
+    :   m_pdst(pdst)
+    {}
+
+    KEWB_FORCE_INLINE void
+        put(rf512 block)
+    {
+        store_to_address(m_pdst, block);
+        m_pdst += 16;
+    }
+
+    KEWB_FORCE_INLINE void
+        put_last(rf512 block, size_t count)
+    {
+        masked_store_to(m_pdst, block, ~(0xffffffff << count));
+    }
+
+private:
+    float*  m_pdst;
+};
+
+//- CachedWriter for a kernel that starts up to 15 samples before the output: the first 'skip'
+//  (< 16) lanes of the first block are dropped, and the block is stored at 'pdst - skip'. Only
+//  the first block takes a masked store.
+//
+class SkippingWriter
+{
+public:
+    SkippingWriter(float* pdst, size_t skip)
+    :   m_pdst(pdst - skip),
+        m_head(0xFFFFu << skip)
+    {}
+
+    KEWB_FORCE_INLINE void
+        put(rf512 block)
+    {
+        if (m_head != 0xFFFFu)
+        {
+            masked_store_to(m_pdst, block, m_head);
+            m_head = 0xFFFFu;
+        }
+        else
+        {
+            store_to_address(m_pdst, block);
+        }
+        m_pdst += 16;
+    }
+
+    KEWB_FORCE_INLINE void
+        put_last(rf512 block, size_t count)
+    {
+        masked_store_to(m_pdst, block, m_head & ~(0xffffffff << count));
+    }
+
+private:
+    float*  m_pdst;
+    m512    m_head;     //- Lanes of the first block that belong to the output
+};
+
+//- Stores like CachedWriter and records in 'changed' the lanes whose output differs, bit for bit,
+//  from the input sample at the same position in 'psrc'; the input is read before each store,
+//  so 'pdst' may equal 'psrc'.
+//
+class ChangeTrackingWriter
+{
+public:
+    ChangeTrackingWriter(float* pdst, const float* psrc, m512& changed)
+    :   m_pdst(pdst),
+        m_psrc(psrc),
+        m_changed(changed)
+    {}
+
+    KEWB_FORCE_INLINE void
+        put(rf512 block)
+    {
+        m_changed |= _mm512_cmpneq_epi32_mask(_mm512_castps_si512(block), _mm512_loadu_si512(m_psrc));
+        store_to_address(m_pdst, block);
+        m_pdst += 16;
+        m_psrc += 16;
+    }
+
+    KEWB_FORCE_INLINE void
+        put_last(rf512 block, size_t count)
+    {
+        m512 const      mask = ~(0xffffffff << count);
+        ri512 const     input = _mm512_maskz_loadu_epi32((__mmask16)mask, m_psrc);
+
+        m_changed |= _mm512_mask_cmpneq_epi32_mask((__mmask16)mask, _mm512_castps_si512(block), input);
+        masked_store_to(m_pdst, block, mask);
+    }
+
+private:
+    float*          m_pdst;
+    const float*    m_psrc;
+    m512&           m_changed;
+};
+
+//- Non-temporal stores for outputs much larger than the last level cache: destination lines are
+//  written without a read for ownership and without evicting the input. The blocks are re-cut
+//  at 64-byte boundaries, one two-source permute per block; the unaligned first and last lines
+//  are written with ordinary masked stores.
+//
+class StreamingWriter
+{
+public:
+    explicit StreamingWriter(float* pdst)
+    :   m_offset(((uintptr_t)pdst / sizeof(float)) % 16),
+        m_line(pdst - m_offset),
+        m_recut(_mm512_add_epi32(load_values<0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15>(),
+                                 _mm512_set1_epi32((int)(16 - m_offset)))),
+        m_pending(_mm512_setzero_ps()),
+        m_head(0xFFFFu << m_offset)
+    {}
+
+    KEWB_FORCE_INLINE void
+        put(rf512 block)
+    {
+        rf512 const     line = _mm512_permutex2var_ps(m_pending, m_recut, block);
+
+        if (m_head != 0xFFFFu)
+        {
+            masked_store_to(m_line, line, m_head);
+            m_head = 0xFFFFu;
+        }
+        else
+        {
+            _mm512_stream_ps(m_line, line);
+        }
+        m_line += 16;
+        m_pending = block;
+    }
+
+    KEWB_FORCE_INLINE void
+        put_last(rf512 block, size_t count)
+    {
+        size_t const    valid = m_offset + count;   //- Lanes of output left from 'm_line' on
+
+        masked_store_to(m_line, _mm512_permutex2var_ps(m_pending, m_recut, block),
+                        m_head & ~(0xffffffff << std::min<size_t>(valid, 16)));
+        if (valid > 16)
+        {
+            masked_store_to(m_line + 16, _mm512_permutex2var_ps(block, m_recut, block),
+                            ~(0xffffffff << (valid - 16)));
+        }
+        _mm_sfence();
+    }
+
+private:
+    size_t      m_offset;   //- Samples from the preceding 64-byte boundary to the destination
+    float*      m_line;     //- Next 64-byte line to be written
+    ri512       m_recut;    //- Selects the line from the tail of one block and the head of the next
+    rf512       m_pending;  //- Previous block; its last 'm_offset' lanes are not yet written
+    m512        m_head;     //- Lanes of the first line that belong to the destination
+};
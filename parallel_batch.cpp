@@ -0,0 +1,312 @@
+#include "avx-median.h"
+#include "selection_network.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+//- Many short series at once. Up to 16 series are transposed into the lanes of a tile, so that
+//  register 't' of the tile holds sample 't' of every series; the median then runs down the tile
+//  with one selection network per 16 outputs and no lane shuffles at all, and the tile is
+//  transposed back into the series. The per-call prologue and the edge handling of
+//  median_Parallel are paid once per 16 series instead of once per series.
+//
+//  Series of different lengths share a tile by repeating the last sample of the shorter ones,
+//  which is exactly the trailing edge replication of the 1D filter.
+//
+namespace
+{
+
+constexpr size_t    lanes = 16;
+
+//- Series longer than this are filtered on their own: median_Parallel has amortised its prologue
+//  by then, and the two transposes no longer pay for themselves. For median_batch the break-even
+//  is near 64 samples, where batching only ties the loop; the cap is the bin boundary below it.
+//
+constexpr size_t    longest_batched = 48;
+
+//- median_rows has a single length and no bins, so its cap is the measured break-even itself:
+//  the transposed rows still beat one median_Parallel call per row at 80 samples, and only tie
+//  it from 96 on.
+//
+constexpr size_t    longest_rows = 80;
+
+KEWB_FORCE_INLINE
+m512 lane_mask(size_t count)
+{
+    return (count >= 16) ? 0xFFFFu : ~(0xffffffff << count);
+}
+
+KEWB_FORCE_INLINE
+rf512 unpacklo_pd(rf512 a, rf512 b)
+{
+    return _mm512_castpd_ps(_mm512_unpacklo_pd(_mm512_castps_pd(a), _mm512_castps_pd(b)));
+}
+
+KEWB_FORCE_INLINE
+rf512 unpackhi_pd(rf512 a, rf512 b)
+{
+    return _mm512_castpd_ps(_mm512_unpackhi_pd(_mm512_castps_pd(a), _mm512_castps_pd(b)));
+}
+
+//- Calls 'f' with 0 .. N - 1 as compile-time constants, so that register arrays indexed by them
+//  stay in registers.
+//
+template<typename F, size_t... I>
+KEWB_FORCE_INLINE
+void unrolled(F&& f, std::index_sequence<I...>)
+{
+    (f(std::integral_constant<size_t, I>()), ...);
+}
+
+template<size_t N, typename F>
+KEWB_FORCE_INLINE
+void unrolled(F&& f)
+{
+    unrolled(f, std::make_index_sequence<N>());
+}
+
+//- The four stages of the in-register 16 x 16 transpose, written as folds so that the register
+//  arrays are never spilled.
+//
+template<size_t... I>
+KEWB_FORCE_INLINE
+void transpose_ps(const rf512* r, rf512* t, std::index_sequence<I...>)
+{
+    ((t[2 * I + 0] = _mm512_unpacklo_ps(r[2 * I], r[2 * I + 1]),
+      t[2 * I + 1] = _mm512_unpackhi_ps(r[2 * I], r[2 * I + 1])), ...);
+}
+
+template<size_t... I>
+KEWB_FORCE_INLINE
+void transpose_pd(const rf512* t, rf512* r, std::index_sequence<I...>)
+{
+    ((r[4 * I + 0] = unpacklo_pd(t[4 * I + 0], t[4 * I + 2]),
+      r[4 * I + 1] = unpackhi_pd(t[4 * I + 0], t[4 * I + 2]),
+      r[4 * I + 2] = unpacklo_pd(t[4 * I + 1], t[4 * I + 3]),
+      r[4 * I + 3] = unpackhi_pd(t[4 * I + 1], t[4 * I + 3])), ...);
+}
+
+//- Pairs register 'j' with register 'j + Stride', for the I-th such pair.
+//
+template<size_t Stride>
+constexpr size_t    block_pair(size_t i)
+{
+    return i / Stride * 2 * Stride + i % Stride;
+}
+
+template<size_t Stride, size_t... I>
+KEWB_FORCE_INLINE
+void transpose_blocks(const rf512* r, rf512* t, std::index_sequence<I...>)
+{
+    ((t[block_pair<Stride>(I)] = _mm512_shuffle_f32x4(r[block_pair<Stride>(I)], r[block_pair<Stride>(I) + Stride], 0x88),
+      t[block_pair<Stride>(I) + Stride] = _mm512_shuffle_f32x4(r[block_pair<Stride>(I)], r[block_pair<Stride>(I) + Stride], 0xDD)), ...);
+}
+
+//- In-register 16 x 16 transpose: lane 'i' of 'r[j]' is swapped with lane 'j' of 'r[i]'.
+//
+KEWB_FORCE_INLINE
+void transpose16(rf512* r)
+{
+    rf512   t[16];
+
+    transpose_ps(r, t, std::make_index_sequence<8>());
+    transpose_pd(t, r, std::make_index_sequence<4>());
+    transpose_blocks<4>(r, t, std::make_index_sequence<8>());
+    transpose_blocks<8>(t, r, std::make_index_sequence<8>());
+}
+
+KEWB_FORCE_INLINE
+rf512 median7(rf512 x0, rf512 x1, rf512 x2, rf512 x3, rf512 x4, rf512 x5, rf512 x6)
+{
+    rf512   s[] = { x0, x1, x2, x3, x4, x5, x6 };
+
+    apply_network<selection_network<7, 3>>(s);
+    return s[3];
+}
+
+//- Filters 'count' (<= 16) non-empty series through one tile. 'tile' is scratch space that is
+//  grown as needed.
+//
+void median_lanes(const float* const* srcs, float* const* dsts, const size_t* lens, size_t count,
+                  std::vector<float>& tile)
+{
+    size_t const    len = *std::max_element(lens, lens + count);
+    size_t const    padded = (len + lanes - 1) / lanes * lanes;
+
+    tile.resize((padded + 6) * lanes);
+
+    float* const    body = tile.data() + 3 * lanes;     //- Row 't' holds sample 't' of every series
+    rf512           r[lanes];
+
+    //- Transpose the series into the tile; samples past the end of a series repeat its last one.
+    //
+    for (size_t t0 = 0; t0 < len; t0 += lanes)
+    {
+        unrolled<lanes>([&](auto i)
+        {
+            if (i >= count)
+            {
+                r[i] = _mm512_setzero_ps();
+            }
+            else if (t0 + lanes <= lens[i])
+            {
+                r[i] = load_from(srcs[i] + t0);
+            }
+            else if (t0 < lens[i])
+            {
+                r[i] = masked_load_from(srcs[i] + t0, load_value(srcs[i][lens[i] - 1]), lane_mask(lens[i] - t0));
+            }
+            else
+            {
+                r[i] = load_value(srcs[i][lens[i] - 1]);
+            }
+        });
+
+        transpose16(r);
+
+        unrolled<lanes>([&](auto j) { store_to_address(body + (t0 + j) * lanes, r[j]); });
+    }
+
+    //- Replicate the first and last rows into the leading and trailing halo.
+    //
+    rf512 const     first = load_from(body);
+    rf512 const     last = load_from(body + (len - 1) * lanes);
+
+    for (size_t k = 1; k <= 3; ++k)
+    {
+        store_to_address(body - k * lanes, first);
+        store_to_address(body + (len - 1 + k) * lanes, last);
+    }
+
+    //- Median down the tile, in place: row 't' is only overwritten once it has been read.
+    //
+    rf512   x0 = first, x1 = first, x2 = first;
+    rf512   x3 = load_from(body);
+    rf512   x4 = load_from(body + 1 * lanes);
+    rf512   x5 = load_from(body + 2 * lanes);
+    rf512   x6;
+
+    for (size_t t = 0; t < len; ++t)
+    {
+        x6 = load_from(body + (t + 3) * lanes);
+        store_to_address(body + t * lanes, median7(x0, x1, x2, x3, x4, x5, x6));
+        x0 = x1; x1 = x2; x2 = x3; x3 = x4; x4 = x5; x5 = x6;
+    }
+
+    //- Transpose back into the series.
+    //
+    for (size_t t0 = 0; t0 < len; t0 += lanes)
+    {
+        unrolled<lanes>([&](auto j) { r[j] = load_from(body + (t0 + j) * lanes); });
+
+        transpose16(r);
+
+        unrolled<lanes>([&](auto i)
+        {
+            if (i >= count)
+            {
+                return;
+            }
+            if (t0 + lanes <= lens[i])
+            {
+                store_to_address(dsts[i] + t0, r[i]);
+            }
+            else if (t0 < lens[i])
+            {
+                masked_store_to(dsts[i] + t0, r[i], lane_mask(lens[i] - t0));
+            }
+        });
+    }
+}
+
+}   // namespace
+
+void median_batch(const float* const* srcs, float* const* dsts, const size_t* lens, size_t count)
+{
+    //- Series are binned by the number of 16-sample blocks they span, so that few lanes of a tile
+    //  idle on padding; a bin is filtered as soon as it holds 16 series.
+    //
+    constexpr size_t    bins = longest_batched / lanes;
+
+    struct Bin
+    {
+        const float*    srcs[lanes];
+        float*          dsts[lanes];
+        size_t          lens[lanes];
+        size_t          count;
+    };
+
+    std::vector<float>  tile;
+    Bin                 binned[bins];
+
+    for (Bin& bin : binned)
+    {
+        bin.count = 0;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (lens[i] > longest_batched)
+        {
+            median_Parallel(srcs[i], dsts[i], lens[i]);
+        }
+        else if (lens[i] > 0)
+        {
+            Bin&    bin = binned[(lens[i] - 1) / lanes];
+
+            bin.srcs[bin.count] = srcs[i];
+            bin.dsts[bin.count] = dsts[i];
+            bin.lens[bin.count] = lens[i];
+
+            if (++bin.count == lanes)
+            {
+                median_lanes(bin.srcs, bin.dsts, bin.lens, bin.count, tile);
+                bin.count = 0;
+            }
+        }
+    }
+
+    for (Bin& bin : binned)
+    {
+        if (bin.count != 0)
+        {
+            median_lanes(bin.srcs, bin.dsts, bin.lens, bin.count, tile);
+        }
+    }
+}
+
+void median_rows(const float* psrc, size_t src_stride, float* pdst, size_t dst_stride, size_t len, size_t rows)
+{
+    std::vector<float>      tile;
+    const float*            group_srcs[lanes];
+    float*                  group_dsts[lanes];
+    size_t                  group_lens[lanes];
+
+    if (len == 0)
+    {
+        return;
+    }
+    if (len > longest_rows)
+    {
+        for (size_t i = 0; i < rows; ++i)
+        {
+            median_Parallel(psrc + i * src_stride, pdst + i * dst_stride, len);
+        }
+        return;
+    }
+
+    std::fill_n(group_lens, lanes, len);
+
+    for (size_t row = 0; row < rows; row += lanes)
+    {
+        size_t const    count = std::min(lanes, rows - row);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            group_srcs[i] = psrc + (row + i) * src_stride;
+            group_dsts[i] = pdst + (row + i) * dst_stride;
+        }
+        median_lanes(group_srcs, group_dsts, group_lens, count, tile);
+    }
+}
@@ -0,0 +1,265 @@
+#include "avx-median.h"
+#include "stepwise_gather.h"
+
+//- Double precision variants of median_Parallel and median_Parallel_step1, 8 samples per
+//  register. The networks are the ones used for floats; only the register width and the
+//  permutations change.
+//
+KEWB_FORCE_INLINE
+static void sort(rd512& l, rd512& r)
+{
+    rd512 tmp = minimum(l, r);
+    r = maximum(l, r);
+    l = tmp;
+}
+
+KEWB_FORCE_INLINE
+static rd512 process8(rd512 s1, rd512 hi)
+{
+    rd512 s2 = shift_up_with_carry<7>(s1, hi);
+    rd512 s3 = shift_up_with_carry<6>(s1, hi);
+    rd512 s4 = shift_up_with_carry<5>(s1, hi);
+    rd512 s5 = shift_up_with_carry<4>(s1, hi);
+    rd512 s6 = shift_up_with_carry<3>(s1, hi);
+    rd512 s7 = shift_up_with_carry<2>(s1, hi);
+    sort(s2, s3); sort(s4, s5); sort(s6, s7);
+    sort(s1, s3); sort(s5, s7); sort(s4, s6);
+    s3 = minimum(s3, s7); sort(s2, s6); sort(s1, s5);
+    s3 = minimum(s3, s6); s4 = maximum(s4, s1);
+    s3 = minimum(s3, s5); s4 = maximum(s2, s4);
+    s4 = maximum(s3, s4);
+    return s4;
+}
+
+void median_Parallel(const double* psrc, double* pdst, size_t buf_len)
+{
+    __m512d     prev;   //- Bottom of the input data window
+    __m512d     curr;   //- Middle of the input data window
+    __m512d     next;   //- Top of the input data window
+    __m512d     lo;     //- Primary work register
+    __m512d     hi;     //- Upper work data register; feeds values into the top of 'lo'
+    m512        mask;   //- Trailing boundary mask
+    __m512d     data;   //- Holds output prior to store operation
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    rd512 const     first = load_value(psrc[0]);
+    rd512 const     last = load_value(psrc[buf_len - 1]);
+
+    if (buf_len < 8)
+    {
+        prev = first;
+        mask = ~(0xffffffff << buf_len);
+        curr = masked_load_from(psrc, last, mask);
+        next = last;
+
+        //- Init the work data register to the correct offset in the input data window.
+        //
+        lo = shift_up_with_carry<3>(prev, curr);
+        hi = shift_up_with_carry<3>(curr, next);
+
+        data = process8(lo, hi);
+        masked_store_to(pdst, data, mask);
+    }
+    else
+    {
+        size_t  read = 0;
+        size_t  used = 0;
+        size_t  wrote = 0;
+
+        curr = first;
+        next = load_from(psrc);
+        read += 8;
+        used += 8;
+
+        while (used < (buf_len + 8))
+        {
+            prev = curr;
+            curr = next;
+
+            if (read <= (buf_len - 8))
+            {
+                next = load_from(psrc + read);
+                read += 8;
+            }
+            else
+            {
+                mask = ~(0xffffffff << (buf_len - read));
+                next = masked_load_from(psrc + read, last, mask);
+                read = buf_len;
+            }
+            used += 8;
+
+            //- Init the work data register to the correct offset in the input data window.
+            //
+            lo = shift_up_with_carry<3>(prev, curr);
+            hi = shift_up_with_carry<3>(curr, next);
+
+            data = process8(lo, hi);
+
+            if (wrote <= (buf_len - 8))
+            {
+                store_to_address(pdst + wrote, data);
+                wrote += 8;
+            }
+            else
+            {
+                mask = ~(0xffffffff << (buf_len - wrote));
+                masked_store_to(pdst + wrote, data, mask);
+                wrote = buf_len;
+            }
+        }
+    }
+}
+
+static const     auto Ys_perm_lo = make_permute64<0, 7, 2, 0, 4, 0, 6, 0>();
+static constexpr auto Ys_mask_hi = make_bitmask<0, 0, 0, 1, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0>();
+static const     auto Ys_perm_hi = make_permute64<0, 0, 0, 1, 0, 3, 0, 5>();
+
+static const     auto pairwise_broadcast_perm_lo = make_permute64<0, 0, 1, 1, 2, 2, 3, 3>();
+static const     auto pairwise_broadcast_perm_hi = make_permute64<4, 4, 5, 5, 6, 6, 7, 7>();
+
+static const StepwiseGather<1, 8> G1;
+static const StepwiseGather<2, 8> G2;
+static const StepwiseGather<3, 8> G3;
+static const StepwiseGather<4, 8> G4;
+static const StepwiseGather<5, 8> G5;
+static const StepwiseGather<6, 8> G6;
+
+KEWB_FORCE_INLINE
+static void process16(rd512& lo, rd512 med, rd512& hi)
+{
+    rd512 Ys_lo = permute(lo, Ys_perm_lo);
+    Ys_lo = mask_permute(Ys_lo, med, Ys_perm_hi, Ys_mask_hi);
+    rd512 Ys_hi = permute(med, Ys_perm_lo);
+    Ys_hi = mask_permute(Ys_hi, hi, Ys_perm_hi, Ys_mask_hi);
+
+    rd512 s1 = G1(lo, med, hi);
+    rd512 s2 = G2(lo, med, hi);
+    rd512 s3 = G3(lo, med, hi);
+    rd512 s4 = G4(lo, med, hi);
+    rd512 s5 = G5(lo, med, hi);
+    rd512 s6 = G6(lo, med, hi);
+    sort(s1, s2); sort(s3, s4); sort(s5, s6);
+    sort(s1, s3); sort(s2, s5); sort(s4, s6);
+    s2 = maximum(s1, s2); sort(s3, s4); s5 = minimum(s5, s6);
+    s3 = maximum(s2, s3); s4 = minimum(s4, s5);
+    sort(s3, s4);
+
+    rd512 tmp = permute(s3, pairwise_broadcast_perm_lo);
+    Ys_lo = maximum(Ys_lo, tmp);
+    tmp = permute(s4, pairwise_broadcast_perm_lo);
+    lo = minimum(Ys_lo, tmp);
+
+    tmp = permute(s3, pairwise_broadcast_perm_hi);
+    Ys_hi = maximum(Ys_hi, tmp);
+    tmp = permute(s4, pairwise_broadcast_perm_hi);
+    hi = minimum(Ys_hi, tmp);
+}
+
+void median_Parallel_step1(const double* psrc, double* pdst, size_t buf_len)
+{
+    __m512d     prev;   //- Bottom of the input data window
+    __m512d     curr_lo, curr_hi;   //- Middle of the input data window
+    __m512d     next;   //- Top of the input data window
+    __m512d     lo, med, hi;
+    m512        mask;   //- Trailing boundary mask
+
+    if (buf_len == 0)
+        return;
+    if (buf_len == 1)
+    {
+        *pdst = *psrc;
+        return;
+    }
+
+    rd512 const     first = load_value(psrc[0]);
+    rd512 const     last = load_value(psrc[buf_len - 1]);
+
+    if (buf_len < 8)
+    {
+        prev = first;
+        mask = ~(0xffffffff << buf_len);
+        curr_lo = masked_load_from(psrc, last, mask);
+        curr_hi = next = last;
+
+        lo = shift_up_with_carry<3>(prev, curr_lo);
+        med = shift_up_with_carry<3>(curr_lo, curr_hi);
+        hi = shift_up_with_carry<3>(curr_hi, next);
+
+        process16(lo, med, hi);
+        masked_store_to(pdst, lo, mask);
+        return;
+    }
+
+    curr_hi = first;
+    next = load_from(psrc); psrc += 8; buf_len -= 8;
+
+    while (buf_len >= 16)
+    {
+        prev = curr_hi;
+        curr_lo = next;
+        curr_hi = load_from(psrc); psrc += 8;
+        next = load_from(psrc); psrc += 8;
+
+        lo = shift_up_with_carry<3>(prev, curr_lo);
+        med = shift_up_with_carry<3>(curr_lo, curr_hi);
+        hi = shift_up_with_carry<3>(curr_hi, next);
+
+        process16(lo, med, hi);
+
+        store_to_address(pdst, lo); pdst += 8;
+        store_to_address(pdst, hi); pdst += 8;
+        buf_len -= 16;
+    }
+
+    prev = curr_hi;
+    curr_lo = next;
+    if (buf_len >= 8)
+    {
+        curr_hi = load_from(psrc); psrc += 8; buf_len -= 8;
+        mask = ~(0xffffffff << buf_len);
+        next = masked_load_from(psrc, last, mask);
+
+        lo = shift_up_with_carry<3>(prev, curr_lo);
+        med = shift_up_with_carry<3>(curr_lo, curr_hi);
+        hi = shift_up_with_carry<3>(curr_hi, next);
+
+        process16(lo, med, hi);
+
+        store_to_address(pdst, lo); pdst += 8;
+        store_to_address(pdst, hi); pdst += 8;
+
+        if (buf_len > 0)
+        {
+            prev = curr_hi;
+            curr_lo = next;
+            curr_hi = next = last;
+
+            lo = shift_up_with_carry<3>(prev, curr_lo);
+            med = shift_up_with_carry<3>(curr_lo, curr_hi);
+            hi = shift_up_with_carry<3>(curr_hi, next);
+
+            process16(lo, med, hi);
+            masked_store_to(pdst, lo, mask);
+        }
+    }
+    else
+    {
+        mask = ~(0xffffffff << buf_len);
+        curr_hi = masked_load_from(psrc, last, mask);
+        next = last;
+
+        lo = shift_up_with_carry<3>(prev, curr_lo);
+        med = shift_up_with_carry<3>(curr_lo, curr_hi);
+        hi = shift_up_with_carry<3>(curr_hi, next);
+
+        process16(lo, med, hi);
+
+        store_to_address(pdst, lo); pdst += 8;
+        masked_store_to(pdst, hi, mask);
+    }
+}
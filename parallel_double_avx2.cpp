@@ -0,0 +1,316 @@
+#include "avx-median.h"
+
+//- AVX2 variants of the double precision kernels, 4 samples per register. With only 4 lanes the
+//  work register pair 'lo | hi' used by median_Parallel_avx2 cannot hold the whole 7-sample
+//  window, so the taps are taken directly from 'prev | curr | next'.
+//
+KEWB_FORCE_INLINE __m256d
+load_value_avx2(double v)
+{
+    return _mm256_set1_pd(v);
+}
+
+KEWB_FORCE_INLINE __m256d
+load_from_avx2(double const* psrc)
+{
+    return _mm256_loadu_pd(psrc);
+}
+
+KEWB_FORCE_INLINE void
+store_to_address(double* pdst, __m256d r)
+{
+    _mm256_storeu_pd(pdst, r);
+}
+
+KEWB_FORCE_INLINE
+static __m256i make_loadmask(size_t value)
+{
+    return _mm256_cmpgt_epi64(_mm256_set1_epi64x((long long)value), _mm256_setr_epi64x(0, 1, 2, 3));
+}
+
+KEWB_FORCE_INLINE __m256d
+masked_load_from(double const* psrc, __m256d fill, __m256i mask)
+{
+    __m256d values = _mm256_maskload_pd(psrc, mask);
+    return _mm256_blendv_pd(fill, values, _mm256_castsi256_pd(mask));
+}
+
+KEWB_FORCE_INLINE void
+masked_store_to(double* pdst, __m256d r, __m256i mask)
+{
+    _mm256_maskstore_pd(pdst, mask, r);
+}
+
+KEWB_FORCE_INLINE
+static __m256d minimum(__m256d l, __m256d r)
+{
+    return _mm256_min_pd(l, r);
+}
+
+KEWB_FORCE_INLINE
+static __m256d maximum(__m256d l, __m256d r)
+{
+    return _mm256_max_pd(l, r);
+}
+
+KEWB_FORCE_INLINE
+static void sort(__m256d& l, __m256d& r)
+{
+    __m256d tmp = minimum(l, r);
+    r = maximum(l, r);
+    l = tmp;
+}
+
+//- Lane i of the result holds element i + D of 'prev | curr | next'.
+//
+template<int D>
+KEWB_FORCE_INLINE __m256d
+window_tap(__m256d prev, __m256d curr, __m256d next)
+{
+    static_assert(D >= -4 && D <= 4);
+
+    if constexpr (D == 0)
+    {
+        return curr;
+    }
+    else
+    {
+        constexpr int   S = (D + 4) % 4;
+        constexpr int   imm = ((S + 0) % 4) | (((S + 1) % 4) << 2) | (((S + 2) % 4) << 4) | (((S + 3) % 4) << 6);
+        constexpr int   from_hi = (D < 0) ? (0xF << -D) & 0xF : (0xF << (4 - D)) & 0xF;
+
+        __m256d const   lo = _mm256_permute4x64_pd((D < 0) ? prev : curr, imm);
+        __m256d const   hi = _mm256_permute4x64_pd((D < 0) ? curr : next, imm);
+        return _mm256_blend_pd(lo, hi, from_hi);
+    }
+}
+
+KEWB_FORCE_INLINE
+static __m256d process4(__m256d prev, __m256d curr, __m256d next)
+{
+    __m256d s1 = window_tap<-3>(prev, curr, next);
+    __m256d s2 = window_tap<-2>(prev, curr, next);
+    __m256d s3 = window_tap<-1>(prev, curr, next);
+    __m256d s4 = curr;
+    __m256d s5 = window_tap<1>(prev, curr, next);
+    __m256d s6 = window_tap<2>(prev, curr, next);
+    __m256d s7 = window_tap<3>(prev, curr, next);
+    sort(s2, s3); sort(s4, s5); sort(s6, s7);
+    sort(s1, s3); sort(s5, s7); sort(s4, s6);
+    s3 = minimum(s3, s7); sort(s2, s6); sort(s1, s5);
+    s3 = minimum(s3, s6); s4 = maximum(s4, s1);
+    s3 = minimum(s3, s5); s4 = maximum(s2, s4);
+    s4 = maximum(s3, s4);
+    return s4;
+}
+
+void median_Parallel_avx2(const double* psrc, double* pdst, size_t buf_len)
+{
+    __m256d     prev;   //- Bottom of the input data window
+    __m256d     curr;   //- Middle of the input data window
+    __m256d     next;   //- Top of the input data window
+    __m256i     mask;   //- Trailing boundary mask
+    __m256d     data;   //- Holds output prior to store operation
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    __m256d const    first = load_value_avx2(psrc[0]);
+    __m256d const    last = load_value_avx2(psrc[buf_len - 1]);
+
+    if (buf_len < 4)
+    {
+        prev = first;
+        mask = make_loadmask(buf_len);
+        curr = masked_load_from(psrc, last, mask);
+        next = last;
+
+        data = process4(prev, curr, next);
+        masked_store_to(pdst, data, mask);
+    }
+    else
+    {
+        size_t  read = 0;
+        size_t  used = 0;
+        size_t  wrote = 0;
+
+        curr = first;
+        next = load_from_avx2(psrc);
+        read += 4;
+        used += 4;
+
+        while (used < (buf_len + 4))
+        {
+            prev = curr;
+            curr = next;
+
+            if (read <= (buf_len - 4))
+            {
+                next = load_from_avx2(psrc + read);
+                read += 4;
+            }
+            else
+            {
+                mask = make_loadmask(buf_len - read);
+                next = masked_load_from(psrc + read, last, mask);
+                read = buf_len;
+            }
+            used += 4;
+
+            data = process4(prev, curr, next);
+
+            if (wrote <= (buf_len - 4))
+            {
+                store_to_address(pdst + wrote, data);
+                wrote += 4;
+            }
+            else
+            {
+                mask = make_loadmask(buf_len - wrote);
+                masked_store_to(pdst + wrote, data, mask);
+                wrote = buf_len;
+            }
+        }
+    }
+}
+
+//- Even and odd lanes of 'a | b': '{a0, a2, b0, b2}' and '{a1, a3, b1, b3}'.
+//
+KEWB_FORCE_INLINE
+static __m256d even_lanes(__m256d a, __m256d b)
+{
+    return _mm256_permute4x64_pd(_mm256_unpacklo_pd(a, b), 0xD8);
+}
+
+KEWB_FORCE_INLINE
+static __m256d odd_lanes(__m256d a, __m256d b)
+{
+    return _mm256_permute4x64_pd(_mm256_unpackhi_pd(a, b), 0xD8);
+}
+
+//- Step1 pairwise sharing on 4-lane registers: outputs '2k' and '2k + 1' share 6 of their 7
+//  inputs. The taps of 'lo' and 'hi' (8 outputs) are split into even and odd lanes so that lane k
+//  of each of the 6 shared registers holds the inputs of pair k; the medians of the pairs are
+//  then built from the sorted middle two and each output's own extra input.
+//
+KEWB_FORCE_INLINE
+static void process8(__m256d prev, __m256d& lo, __m256d& hi, __m256d next)
+{
+    __m256d s1 = even_lanes(window_tap<-2>(prev, lo, hi), window_tap<-2>(lo, hi, next));
+    __m256d s2 = odd_lanes(window_tap<-2>(prev, lo, hi), window_tap<-2>(lo, hi, next));
+    __m256d s3 = even_lanes(lo, hi);
+    __m256d s4 = odd_lanes(lo, hi);
+    __m256d s5 = even_lanes(window_tap<2>(prev, lo, hi), window_tap<2>(lo, hi, next));
+    __m256d s6 = odd_lanes(window_tap<2>(prev, lo, hi), window_tap<2>(lo, hi, next));
+    __m256d Ys_even = odd_lanes(prev, lo);
+    __m256d Ys_odd = even_lanes(hi, next);
+    sort(s1, s2); sort(s3, s4); sort(s5, s6);
+    sort(s1, s3); sort(s2, s5); sort(s4, s6);
+    s2 = maximum(s1, s2); sort(s3, s4); s5 = minimum(s5, s6);
+    s3 = maximum(s2, s3); s4 = minimum(s4, s5);
+    sort(s3, s4);
+
+    __m256d even = minimum(maximum(Ys_even, s3), s4);
+    __m256d odd = minimum(maximum(Ys_odd, s3), s4);
+
+    __m256d pairs_lo = _mm256_unpacklo_pd(even, odd);   //- {e0, o0, e2, o2}
+    __m256d pairs_hi = _mm256_unpackhi_pd(even, odd);   //- {e1, o1, e3, o3}
+    lo = _mm256_permute2f128_pd(pairs_lo, pairs_hi, 0x20);
+    hi = _mm256_permute2f128_pd(pairs_lo, pairs_hi, 0x31);
+}
+
+void median_Parallel_step1_avx2(const double* psrc, double* pdst, size_t buf_len)
+{
+    __m256d     prev;   //- Bottom of the input data window
+    __m256d     curr_lo, curr_hi;   //- Middle of the input data window
+    __m256d     next;   //- Top of the input data window
+    __m256d     lo, hi; //- Work registers; hold the output after processing
+    __m256i     mask;   //- Trailing boundary mask
+
+    if (buf_len == 0)
+        return;
+    if (buf_len == 1)
+    {
+        *pdst = *psrc;
+        return;
+    }
+
+    __m256d const    first = load_value_avx2(psrc[0]);
+    __m256d const    last = load_value_avx2(psrc[buf_len - 1]);
+
+    if (buf_len < 4)
+    {
+        prev = first;
+        mask = make_loadmask(buf_len);
+        curr_lo = masked_load_from(psrc, last, mask);
+        curr_hi = next = last;
+
+        lo = curr_lo;
+        hi = curr_hi;
+        process8(prev, lo, hi, next);
+        masked_store_to(pdst, lo, mask);
+        return;
+    }
+
+    curr_hi = first;
+    next = load_from_avx2(psrc); psrc += 4; buf_len -= 4;
+
+    while (buf_len >= 8)
+    {
+        prev = curr_hi;
+        curr_lo = next;
+        curr_hi = load_from_avx2(psrc); psrc += 4;
+        next = load_from_avx2(psrc); psrc += 4;
+
+        lo = curr_lo;
+        hi = curr_hi;
+        process8(prev, lo, hi, next);
+
+        store_to_address(pdst, lo); pdst += 4;
+        store_to_address(pdst, hi); pdst += 4;
+        buf_len -= 8;
+    }
+
+    prev = curr_hi;
+    curr_lo = next;
+    if (buf_len >= 4)
+    {
+        curr_hi = load_from_avx2(psrc); psrc += 4; buf_len -= 4;
+        mask = make_loadmask(buf_len);
+        next = masked_load_from(psrc, last, mask);
+
+        lo = curr_lo;
+        hi = curr_hi;
+        process8(prev, lo, hi, next);
+
+        store_to_address(pdst, lo); pdst += 4;
+        store_to_address(pdst, hi); pdst += 4;
+
+        if (buf_len > 0)
+        {
+            prev = curr_hi;
+            curr_lo = next;
+            curr_hi = next = last;
+
+            lo = curr_lo;
+            hi = curr_hi;
+            process8(prev, lo, hi, next);
+            masked_store_to(pdst, lo, mask);
+        }
+    }
+    else
+    {
+        mask = make_loadmask(buf_len);
+        curr_hi = masked_load_from(psrc, last, mask);
+        next = last;
+
+        lo = curr_lo;
+        hi = curr_hi;
+        process8(prev, lo, hi, next);
+
+        store_to_address(pdst, lo); pdst += 4;
+        masked_store_to(pdst, hi, mask);
+    }
+}
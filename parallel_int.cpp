@@ -0,0 +1,231 @@
+#include "avx-median.h"
+#include "selection_network.h"
+
+//- Integer variants of median_Parallel. The selection network is the same as for floats; only
+//  the lane count changes with the element size (64 x uint8, 32 x int16/uint16, 16 x int32), so
+//  narrow types filter 4x or 2x as many samples per instruction.
+//
+//  The window taps are built with 'valignd' (to move 16-byte blocks across the register) followed
+//  by 'vpalignr' (to shift bytes within each 16-byte block). A byte permute across the whole
+//  register needs AVX-512 VBMI. AVX-512BW does have word permutes ('vpermw', 'vpermt2w'), but
+//  the taps on either side of the center share one 'valignd', so a tap costs about one 'vpalignr'.
+//  A 'vpermt2w' per tap measured no faster for int16/uint16.
+//
+namespace
+{
+
+template<typename T>
+struct ivec
+{
+    __m512i     r;
+
+    static constexpr size_t     lanes = 64 / sizeof(T);
+};
+
+KEWB_FORCE_INLINE ivec<uint8_t>  minimum(ivec<uint8_t> a, ivec<uint8_t> b)   { return { _mm512_min_epu8(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<uint8_t>  maximum(ivec<uint8_t> a, ivec<uint8_t> b)   { return { _mm512_max_epu8(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<int16_t>  minimum(ivec<int16_t> a, ivec<int16_t> b)   { return { _mm512_min_epi16(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<int16_t>  maximum(ivec<int16_t> a, ivec<int16_t> b)   { return { _mm512_max_epi16(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<uint16_t> minimum(ivec<uint16_t> a, ivec<uint16_t> b) { return { _mm512_min_epu16(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<uint16_t> maximum(ivec<uint16_t> a, ivec<uint16_t> b) { return { _mm512_max_epu16(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<int32_t>  minimum(ivec<int32_t> a, ivec<int32_t> b)   { return { _mm512_min_epi32(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<int32_t>  maximum(ivec<int32_t> a, ivec<int32_t> b)   { return { _mm512_max_epi32(a.r, b.r) }; }
+
+template<typename T>
+KEWB_FORCE_INLINE ivec<T>
+    load_value(T v)
+{
+    if constexpr (sizeof(T) == 1)
+        return { _mm512_set1_epi8((char)v) };
+    else if constexpr (sizeof(T) == 2)
+        return { _mm512_set1_epi16((short)v) };
+    else
+        return { _mm512_set1_epi32((int)v) };
+}
+
+template<typename T>
+KEWB_FORCE_INLINE ivec<T>
+    load_from(const T* psrc)
+{
+    return { _mm512_loadu_si512(psrc) };
+}
+
+//- Loads the first 'count' (< lanes) elements; the remaining lanes are taken from 'fill'.
+//
+template<typename T>
+KEWB_FORCE_INLINE ivec<T>
+    masked_load_from(const T* psrc, ivec<T> fill, size_t count)
+{
+    if constexpr (sizeof(T) == 1)
+        return { _mm512_mask_loadu_epi8(fill.r, (__mmask64)((1ull << count) - 1), psrc) };
+    else if constexpr (sizeof(T) == 2)
+        return { _mm512_mask_loadu_epi16(fill.r, (__mmask32)((1ull << count) - 1), psrc) };
+    else
+        return { _mm512_mask_loadu_epi32(fill.r, (__mmask16)((1ull << count) - 1), psrc) };
+}
+
+template<typename T>
+KEWB_FORCE_INLINE void
+    store_to_address(T* pdst, ivec<T> r)
+{
+    _mm512_storeu_si512(pdst, r.r);
+}
+
+template<typename T>
+KEWB_FORCE_INLINE void
+    masked_store_to(T* pdst, ivec<T> r, size_t count)
+{
+    if constexpr (sizeof(T) == 1)
+        _mm512_mask_storeu_epi8(pdst, (__mmask64)((1ull << count) - 1), r.r);
+    else if constexpr (sizeof(T) == 2)
+        _mm512_mask_storeu_epi16(pdst, (__mmask32)((1ull << count) - 1), r.r);
+    else
+        _mm512_mask_storeu_epi32(pdst, (__mmask16)((1ull << count) - 1), r.r);
+}
+
+//- Lane i of the result holds element i + D of 'prev | curr | next', for |D| * sizeof(T) < 16.
+//
+template<int D, typename T>
+KEWB_FORCE_INLINE ivec<T>
+    window_tap(ivec<T> prev, ivec<T> curr, ivec<T> next)
+{
+    static_assert(-D * (int)sizeof(T) < 16 && D * (int)sizeof(T) < 16);
+
+    if constexpr (D < 0)
+    {
+        __m512i const   blocks = _mm512_alignr_epi32(curr.r, prev.r, 12);
+        return { _mm512_alignr_epi8(curr.r, blocks, 16 + D * (int)sizeof(T)) };
+    }
+    else if constexpr (D == 0)
+    {
+        return curr;
+    }
+    else
+    {
+        __m512i const   blocks = _mm512_alignr_epi32(next.r, curr.r, 4);
+        return { _mm512_alignr_epi8(blocks, curr.r, D * (int)sizeof(T)) };
+    }
+}
+
+template<typename T>
+KEWB_FORCE_INLINE ivec<T>
+    process(ivec<T> prev, ivec<T> curr, ivec<T> next)
+{
+    ivec<T>     s[] = { window_tap<-3>(prev, curr, next), window_tap<-2>(prev, curr, next),
+                        window_tap<-1>(prev, curr, next), curr,
+                        window_tap<1>(prev, curr, next), window_tap<2>(prev, curr, next),
+                        window_tap<3>(prev, curr, next) };
+
+    apply_network<selection_network<7, 3>>(s);
+    return s[3];
+}
+
+}   // namespace
+
+//- The 3 samples before 'psrc' in the top lanes, 'fill' in the others.
+//
+template<typename T>
+KEWB_FORCE_INLINE ivec<T>
+    load_lead_halo(const T* psrc, ivec<T> fill)
+{
+    constexpr size_t    N = ivec<T>::lanes;
+
+    if constexpr (sizeof(T) == 1)
+        return { _mm512_mask_loadu_epi8(fill.r, (__mmask64)(7ull << (N - 3)), psrc - N) };
+    else if constexpr (sizeof(T) == 2)
+        return { _mm512_mask_loadu_epi16(fill.r, (__mmask32)(7ull << (N - 3)), psrc - N) };
+    else
+        return { _mm512_mask_loadu_epi32(fill.r, (__mmask16)(7ull << (N - 3)), psrc - N) };
+}
+
+template<typename T>
+void median_Parallel(const T* psrc, T* pdst, size_t buf_len)
+{
+    median_Parallel_chunk(psrc, pdst, buf_len, false, false);
+}
+
+//- Same halo conventions as the float median_Parallel_chunk.
+//
+template<typename T>
+void median_Parallel_chunk(const T* psrc, T* pdst, size_t buf_len, bool lead_halo, bool trail_halo)
+{
+    constexpr size_t    N = ivec<T>::lanes;
+
+    ivec<T>     prev;   //- Bottom of the input data window
+    ivec<T>     curr;   //- Middle of the input data window
+    ivec<T>     next;   //- Top of the input data window
+    ivec<T>     data;   //- Holds output prior to store operation
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    size_t const    src_len = trail_halo ? buf_len + 3 : buf_len;   //- Readable input
+
+    ivec<T> const   first = load_value(psrc[0]);
+    ivec<T> const   last = load_value(psrc[src_len - 1]);
+    ivec<T> const   before = lead_halo ? load_lead_halo(psrc, first) : first;
+
+    if (buf_len < N)
+    {
+        prev = before;
+        curr = (src_len < N) ? masked_load_from(psrc, last, src_len) : load_from(psrc);
+        next = (src_len > N) ? masked_load_from(psrc + N, last, src_len - N) : last;
+
+        data = process(prev, curr, next);
+        masked_store_to(pdst, data, buf_len);
+    }
+    else
+    {
+        size_t  read = 0;
+        size_t  used = 0;
+        size_t  wrote = 0;
+
+        curr = before;
+        next = load_from(psrc);
+        read += N;
+        used += N;
+
+        while (used < (buf_len + N))
+        {
+            prev = curr;
+            curr = next;
+
+            if (read <= (src_len - N))
+            {
+                next = load_from(psrc + read);
+                read += N;
+            }
+            else
+            {
+                next = masked_load_from(psrc + read, last, src_len - read);
+                read = src_len;
+            }
+            used += N;
+
+            data = process(prev, curr, next);
+
+            if (wrote <= (buf_len - N))
+            {
+                store_to_address(pdst + wrote, data);
+                wrote += N;
+            }
+            else
+            {
+                masked_store_to(pdst + wrote, data, buf_len - wrote);
+                wrote = buf_len;
+            }
+        }
+    }
+}
+
+template void median_Parallel<uint8_t>(const uint8_t*, uint8_t*, size_t);
+template void median_Parallel<int16_t>(const int16_t*, int16_t*, size_t);
+template void median_Parallel<uint16_t>(const uint16_t*, uint16_t*, size_t);
+template void median_Parallel<int32_t>(const int32_t*, int32_t*, size_t);
+
+template void median_Parallel_chunk<uint8_t>(const uint8_t*, uint8_t*, size_t, bool, bool);
+template void median_Parallel_chunk<int16_t>(const int16_t*, int16_t*, size_t, bool, bool);
+template void median_Parallel_chunk<uint16_t>(const uint16_t*, uint16_t*, size_t, bool, bool);
+template void median_Parallel_chunk<int32_t>(const int32_t*, int32_t*, size_t, bool, bool);
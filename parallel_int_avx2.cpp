@@ -0,0 +1,191 @@
+#include "avx-median.h"
+#include "selection_network.h"
+
+#include <algorithm>
+
+//- AVX2 variants of the integer kernels in parallel_int.cpp: 32 x uint8, 16 x int16/uint16 or
+//  8 x int32 per register. AVX2 has no masked loads for 8- and 16-bit elements, so the trailing
+//  partial register is staged through a small buffer padded with the last element.
+//
+namespace
+{
+
+template<typename T>
+struct ivec
+{
+    __m256i     r;
+
+    static constexpr size_t     lanes = 32 / sizeof(T);
+};
+
+KEWB_FORCE_INLINE ivec<uint8_t>  minimum(ivec<uint8_t> a, ivec<uint8_t> b)   { return { _mm256_min_epu8(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<uint8_t>  maximum(ivec<uint8_t> a, ivec<uint8_t> b)   { return { _mm256_max_epu8(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<int16_t>  minimum(ivec<int16_t> a, ivec<int16_t> b)   { return { _mm256_min_epi16(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<int16_t>  maximum(ivec<int16_t> a, ivec<int16_t> b)   { return { _mm256_max_epi16(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<uint16_t> minimum(ivec<uint16_t> a, ivec<uint16_t> b) { return { _mm256_min_epu16(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<uint16_t> maximum(ivec<uint16_t> a, ivec<uint16_t> b) { return { _mm256_max_epu16(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<int32_t>  minimum(ivec<int32_t> a, ivec<int32_t> b)   { return { _mm256_min_epi32(a.r, b.r) }; }
+KEWB_FORCE_INLINE ivec<int32_t>  maximum(ivec<int32_t> a, ivec<int32_t> b)   { return { _mm256_max_epi32(a.r, b.r) }; }
+
+template<typename T>
+KEWB_FORCE_INLINE ivec<T>
+    load_value(T v)
+{
+    if constexpr (sizeof(T) == 1)
+        return { _mm256_set1_epi8((char)v) };
+    else if constexpr (sizeof(T) == 2)
+        return { _mm256_set1_epi16((short)v) };
+    else
+        return { _mm256_set1_epi32((int)v) };
+}
+
+template<typename T>
+KEWB_FORCE_INLINE ivec<T>
+    load_from(const T* psrc)
+{
+    return { _mm256_loadu_si256((const __m256i*)psrc) };
+}
+
+//- Loads the first 'count' (< lanes) elements; the remaining lanes are set to 'fill'.
+//
+template<typename T>
+KEWB_FORCE_INLINE ivec<T>
+    masked_load_from(const T* psrc, T fill, size_t count)
+{
+    T   staging[ivec<T>::lanes];
+
+    std::fill(std::copy_n(psrc, count, staging), staging + ivec<T>::lanes, fill);
+    return load_from(staging);
+}
+
+template<typename T>
+KEWB_FORCE_INLINE void
+    store_to_address(T* pdst, ivec<T> r)
+{
+    _mm256_storeu_si256((__m256i*)pdst, r.r);
+}
+
+template<typename T>
+KEWB_FORCE_INLINE void
+    masked_store_to(T* pdst, ivec<T> r, size_t count)
+{
+    T   staging[ivec<T>::lanes];
+
+    store_to_address(staging, r);
+    std::copy_n(staging, count, pdst);
+}
+
+//- Lane i of the result holds element i + D of 'prev | curr | next', for |D| * sizeof(T) < 16.
+//
+template<int D, typename T>
+KEWB_FORCE_INLINE ivec<T>
+    window_tap(ivec<T> prev, ivec<T> curr, ivec<T> next)
+{
+    static_assert(-D * (int)sizeof(T) < 16 && D * (int)sizeof(T) < 16);
+
+    if constexpr (D < 0)
+    {
+        __m256i const   blocks = _mm256_permute2x128_si256(prev.r, curr.r, 0x21);
+        return { _mm256_alignr_epi8(curr.r, blocks, 16 + D * (int)sizeof(T)) };
+    }
+    else if constexpr (D == 0)
+    {
+        return curr;
+    }
+    else
+    {
+        __m256i const   blocks = _mm256_permute2x128_si256(curr.r, next.r, 0x21);
+        return { _mm256_alignr_epi8(blocks, curr.r, D * (int)sizeof(T)) };
+    }
+}
+
+template<typename T>
+KEWB_FORCE_INLINE ivec<T>
+    process(ivec<T> prev, ivec<T> curr, ivec<T> next)
+{
+    ivec<T>     s[] = { window_tap<-3>(prev, curr, next), window_tap<-2>(prev, curr, next),
+                        window_tap<-1>(prev, curr, next), curr,
+                        window_tap<1>(prev, curr, next), window_tap<2>(prev, curr, next),
+                        window_tap<3>(prev, curr, next) };
+
+    apply_network<selection_network<7, 3>>(s);
+    return s[3];
+}
+
+}   // namespace
+
+template<typename T>
+void median_Parallel_avx2(const T* psrc, T* pdst, size_t buf_len)
+{
+    constexpr size_t    N = ivec<T>::lanes;
+
+    ivec<T>     prev;   //- Bottom of the input data window
+    ivec<T>     curr;   //- Middle of the input data window
+    ivec<T>     next;   //- Top of the input data window
+    ivec<T>     data;   //- Holds output prior to store operation
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    ivec<T> const   first = load_value(psrc[0]);
+    ivec<T> const   last = load_value(psrc[buf_len - 1]);
+
+    if (buf_len < N)
+    {
+        prev = first;
+        curr = masked_load_from(psrc, psrc[buf_len - 1], buf_len);
+        next = last;
+
+        data = process(prev, curr, next);
+        masked_store_to(pdst, data, buf_len);
+    }
+    else
+    {
+        size_t  read = 0;
+        size_t  used = 0;
+        size_t  wrote = 0;
+
+        curr = first;
+        next = load_from(psrc);
+        read += N;
+        used += N;
+
+        while (used < (buf_len + N))
+        {
+            prev = curr;
+            curr = next;
+
+            if (read <= (buf_len - N))
+            {
+                next = load_from(psrc + read);
+                read += N;
+            }
+            else
+            {
+                next = masked_load_from(psrc + read, psrc[buf_len - 1], buf_len - read);
+                read = buf_len;
+            }
+            used += N;
+
+            data = process(prev, curr, next);
+
+            if (wrote <= (buf_len - N))
+            {
+                store_to_address(pdst + wrote, data);
+                wrote += N;
+            }
+            else
+            {
+                masked_store_to(pdst + wrote, data, buf_len - wrote);
+                wrote = buf_len;
+            }
+        }
+    }
+}
+
+template void median_Parallel_avx2<uint8_t>(const uint8_t*, uint8_t*, size_t);
+template void median_Parallel_avx2<int16_t>(const int16_t*, int16_t*, size_t);
+template void median_Parallel_avx2<uint16_t>(const uint16_t*, uint16_t*, size_t);
+template void median_Parallel_avx2<int32_t>(const int32_t*, int32_t*, size_t);
@@ -0,0 +1,254 @@
+#include "avx-median.h"
+#include "selection_network.h"
+#include "stepwise_gather.h"
+
+#include <utility>
+
+//- Multichannel and strided variants of median_Parallel. Every channel is filtered on its own,
+//  with the same edge replication as median_Parallel, in a single pass over the buffer: the
+//  samples are de-interleaved into one register per channel on the way in (in registers for 2,
+//  3 and 4 channels, with gathers otherwise) and interleaved back on the way out, so no scratch
+//  copies are made.
+//
+namespace
+{
+
+KEWB_FORCE_INLINE
+rf512 process16(rf512 prev, rf512 curr, rf512 next)
+{
+    rf512   s[] = { window_tap<-3>(prev, curr, next), window_tap<-2>(prev, curr, next),
+                    window_tap<-1>(prev, curr, next), curr,
+                    window_tap<1>(prev, curr, next), window_tap<2>(prev, curr, next),
+                    window_tap<3>(prev, curr, next) };
+
+    apply_network<selection_network<7, 3>>(s);
+    return s[3];
+}
+
+template<typename F, int... C>
+KEWB_FORCE_INLINE
+void for_each_channel(F&& f, std::integer_sequence<int, C...>)
+{
+    (f(std::integral_constant<int, C>()), ...);
+}
+
+template<int Channels, typename F>
+KEWB_FORCE_INLINE
+void for_each_channel(F&& f)
+{
+    for_each_channel(f, std::make_integer_sequence<int, Channels>());
+}
+
+KEWB_FORCE_INLINE
+m512 lane_mask(size_t count)
+{
+    return (count >= 16) ? 0xFFFFu : ~(0xffffffff << count);
+}
+
+//- Block access for the loop below: 'load' and 'store' move the 'count' (<= 16) positions
+//  starting at 'pos' of every channel; lanes beyond 'count' are loaded from 'fill'.
+//
+template<int Channels>
+struct InterleavedBlocks
+{
+    static constexpr int    channels = Channels;
+
+    float sample(size_t pos, int c) const
+    {
+        return psrc[pos * Channels + c];
+    }
+
+    KEWB_FORCE_INLINE
+    void load(size_t pos, size_t count, rf512 const* fill, rf512* data) const
+    {
+        float const* const  src = psrc + pos * Channels;
+        rf512               frames[Channels];
+
+        if (count == 16)
+        {
+            for_each_channel<Channels>([&](auto r) { frames[r] = load_from(src + 16 * r); });
+            for_each_channel<Channels>([&](auto c) { data[c] = ChannelGather<Channels>::template channel<c>(frames); });
+        }
+        else
+        {
+            size_t const    samples = count * Channels;
+            m512 const      mask = lane_mask(count);
+
+            for_each_channel<Channels>([&](auto r)
+            {
+                frames[r] = masked_load_from(src + 16 * r, fill[r], (samples > 16 * r) ? lane_mask(samples - 16 * r) : 0);
+            });
+            for_each_channel<Channels>([&](auto c)
+            {
+                data[c] = blend(fill[c], ChannelGather<Channels>::template channel<c>(frames), mask);
+            });
+        }
+    }
+
+    KEWB_FORCE_INLINE
+    void store(size_t pos, size_t count, rf512 const* data) const
+    {
+        float* const    dst = pdst + pos * Channels;
+        size_t const    samples = count * Channels;
+
+        for_each_channel<Channels>([&](auto r)
+        {
+            rf512 const     frame = ChannelGather<Channels>::template frame<r>(data);
+
+            if (samples >= 16 * (r + 1))
+            {
+                store_to_address(dst + 16 * r, frame);
+            }
+            else if (samples > 16 * r)
+            {
+                masked_store_to(dst + 16 * r, frame, lane_mask(samples - 16 * r));
+            }
+        });
+    }
+
+    float const*    psrc;
+    float*          pdst;
+};
+
+struct StridedBlocks
+{
+    static constexpr int    channels = 1;
+
+    float sample(size_t pos, int) const
+    {
+        return psrc[pos * src_stride];
+    }
+
+    KEWB_FORCE_INLINE
+    void load(size_t pos, size_t count, rf512 const* fill, rf512* data) const
+    {
+        data[0] = _mm512_mask_i32gather_ps(fill[0], (__mmask16)lane_mask(count), src_index, psrc + pos * src_stride, 4);
+    }
+
+    KEWB_FORCE_INLINE
+    void store(size_t pos, size_t count, rf512 const* data) const
+    {
+        _mm512_mask_i32scatter_ps(pdst + pos * dst_stride, (__mmask16)lane_mask(count), dst_index, data[0], 4);
+    }
+
+    float const*    psrc;
+    size_t          src_stride;
+    float*          pdst;
+    size_t          dst_stride;
+    __m512i         src_index;
+    __m512i         dst_index;
+};
+
+//- The loop of median_Parallel, run over all channels of 'blocks' side by side.
+//
+template<typename Blocks>
+void median_blocks(Blocks const& blocks, size_t buf_len)
+{
+    constexpr int   C = Blocks::channels;
+
+    rf512   prev[C];    //- Bottom of the input data window, per channel
+    rf512   curr[C];    //- Middle of the input data window, per channel
+    rf512   next[C];    //- Top of the input data window, per channel
+    rf512   data[C];    //- Holds output prior to store operation
+    rf512   first[C];
+    rf512   last[C];
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    for_each_channel<C>([&](auto c)
+    {
+        first[c] = load_value(blocks.sample(0, c));
+        last[c] = load_value(blocks.sample(buf_len - 1, c));
+    });
+
+    if (buf_len < 16)
+    {
+        blocks.load(0, buf_len, last, curr);
+        for_each_channel<C>([&](auto c) { data[c] = process16(first[c], curr[c], last[c]); });
+        blocks.store(0, buf_len, data);
+    }
+    else
+    {
+        size_t  read = 0;
+        size_t  used = 0;
+        size_t  wrote = 0;
+
+        for_each_channel<C>([&](auto c) { curr[c] = first[c]; });
+        blocks.load(0, 16, last, next);
+        read += 16;
+        used += 16;
+
+        while (used < (buf_len + 16))
+        {
+            for_each_channel<C>([&](auto c)
+            {
+                prev[c] = curr[c];
+                curr[c] = next[c];
+            });
+
+            if (read <= (buf_len - 16))
+            {
+                blocks.load(read, 16, last, next);
+                read += 16;
+            }
+            else
+            {
+                blocks.load(read, buf_len - read, last, next);
+                read = buf_len;
+            }
+            used += 16;
+
+            for_each_channel<C>([&](auto c) { data[c] = process16(prev[c], curr[c], next[c]); });
+
+            if (wrote <= (buf_len - 16))
+            {
+                blocks.store(wrote, 16, data);
+                wrote += 16;
+            }
+            else
+            {
+                blocks.store(wrote, buf_len - wrote, data);
+                wrote = buf_len;
+            }
+        }
+    }
+}
+
+}   // namespace
+
+void median_Parallel_strided(const float* psrc, size_t src_stride, float* pdst, size_t dst_stride, size_t buf_len)
+{
+    __m512i const   lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    median_blocks(StridedBlocks{ psrc, src_stride, pdst, dst_stride,
+                                 _mm512_mullo_epi32(lanes, _mm512_set1_epi32((int)src_stride)),
+                                 _mm512_mullo_epi32(lanes, _mm512_set1_epi32((int)dst_stride)) }, buf_len);
+}
+
+void median_Parallel_interleaved(const float* psrc, float* pdst, size_t frames, size_t channels)
+{
+    switch (channels)
+    {
+    case 1:
+        median_Parallel(psrc, pdst, frames);
+        break;
+    case 2:
+        median_blocks(InterleavedBlocks<2>{ psrc, pdst }, frames);
+        break;
+    case 3:
+        median_blocks(InterleavedBlocks<3>{ psrc, pdst }, frames);
+        break;
+    case 4:
+        median_blocks(InterleavedBlocks<4>{ psrc, pdst }, frames);
+        break;
+    default:
+        for (size_t c = 0; c < channels; ++c)
+        {
+            median_Parallel_strided(psrc + c, channels, pdst + c, channels, frames);
+        }
+        break;
+    }
+}
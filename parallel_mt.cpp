@@ -0,0 +1,79 @@
+#include "avx-median.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <vector>
+
+//- Samples per chunk; 128 KB of input plus 128 KB of output stays resident in L2 while a chunk
+//  is filtered.
+//
+static constexpr size_t chunk_len = 32768;
+
+//- Splits the buffer into chunks and runs 'filter(psrc, pdst, len, lead_halo, trail_halo)' over
+//  them on the thread pool.
+//
+template<typename T, typename Filter>
+static void filter_chunks(const T* psrc, T* pdst, size_t buf_len, size_t threads, Filter filter)
+{
+    if (buf_len <= chunk_len)
+    {
+        filter(psrc, pdst, buf_len, false, false);
+        return;
+    }
+
+    //- The last chunk absorbs the remainder, so every trailing halo is backed by real input.
+    //
+    size_t const    chunks = buf_len / chunk_len;
+
+    //- Every chunk only reads its own samples, using its first and last 3 as the halo, and leaves
+    //  the 3 outputs on either side of each interior seam alone. Those are filtered afterwards
+    //  from a copy of the 12 input samples around the seam, taken before any chunk starts
+    //  writing, so 'pdst' may equal 'psrc'.
+    //
+    std::vector<T>  seams((chunks - 1) * 12);
+
+    for (size_t i = 1; i < chunks; ++i)
+    {
+        std::copy_n(psrc + i * chunk_len - 6, 12, seams.data() + (i - 1) * 12);
+    }
+
+    ThreadPool::instance().parallel_for(chunks, threads, [=](size_t i)
+    {
+        size_t const    begin = i * chunk_len;
+        size_t const    len = (i + 1 == chunks) ? buf_len - begin : chunk_len;
+        size_t const    lead = (i != 0) ? 3 : 0;
+        size_t const    trail = (i + 1 != chunks) ? 3 : 0;
+
+        filter(psrc + begin + lead, pdst + begin + lead, len - lead - trail, lead != 0, trail != 0);
+    });
+
+    for (size_t i = 1; i < chunks; ++i)
+    {
+        filter(seams.data() + (i - 1) * 12 + 3, pdst + i * chunk_len - 3, 6, true, true);
+    }
+}
+
+void median_Parallel_mt(const float* psrc, float* pdst, size_t buf_len, size_t threads)
+{
+    bool const  streaming = buf_len >= median_streaming_threshold;
+
+    filter_chunks(psrc, pdst, buf_len, threads,
+                  [streaming](const float* psrc, float* pdst, size_t len, bool lead_halo, bool trail_halo)
+    {
+        median_Parallel_chunk(psrc, pdst, len, lead_halo, trail_halo, streaming && len > 16);
+    });
+}
+
+template<typename T>
+void median_Parallel_mt(const T* psrc, T* pdst, size_t buf_len, size_t threads)
+{
+    filter_chunks(psrc, pdst, buf_len, threads, [](const T* psrc, T* pdst, size_t len, bool lead_halo, bool trail_halo)
+    {
+        median_Parallel_chunk(psrc, pdst, len, lead_halo, trail_halo);
+    });
+}
+
+template void median_Parallel_mt<uint8_t>(const uint8_t*, uint8_t*, size_t, size_t);
+template void median_Parallel_mt<int16_t>(const int16_t*, int16_t*, size_t, size_t);
+template void median_Parallel_mt<uint16_t>(const uint16_t*, uint16_t*, size_t, size_t);
+template void median_Parallel_mt<int32_t>(const int32_t*, int32_t*, size_t, size_t);
@@ -1,203 +1,333 @@
-#include "avx-median.h"
-
-template<int Offset>
-struct StepwiseGather
-{
-    static_assert(Offset < 16, "");
-
-    template<int V> static constexpr uint8_t C = V < 0 ? 0 : V > 15 ? 0 : (uint8_t)V;
-
-    template<int RegStart>
-    static __m512i stepwise_permute()
-    {
-        return make_permute<C<Offset - RegStart>, C<Offset + 2 - RegStart>, C<Offset + 4 - RegStart>, C<Offset + 6 - RegStart>,
-            C<Offset + 8 - RegStart>, C<Offset + 10 - RegStart>, C<Offset + 12 - RegStart>, C<Offset + 14 - RegStart>,
-            C<Offset + 16 - RegStart>, C<Offset + 18 - RegStart>, C<Offset + 20 - RegStart>, C<Offset + 22 - RegStart>,
-            C<Offset + 24 - RegStart>, C<Offset + 26 - RegStart>, C<Offset + 28 - RegStart>, C<Offset + 30 - RegStart>>();
-    }
-
-    template<unsigned int RegStart>
-    static constexpr m512 make_loadmask()
-    {
-        static_assert(Offset < RegStart, "");
-        constexpr auto loaded = (RegStart - Offset + 1) / 2;
-        if constexpr (loaded >= 16)
-            return 0;
-        else
-            return (0xFFFFul << loaded) & 0xFFFF;
-    }
-
-    KEWB_FORCE_INLINE
-    __m512 operator()(__m512 lo, __m512 med, __m512 hi) const noexcept
-    {
-        __m512 data = permute(lo, perm_lo);
-        data = mask_permute(data, med, perm_med, mask_med);
-        if constexpr (mask_hi != 0)
-            data = mask_permute(data, hi, perm_hi, mask_hi);
-        return data;
-    }
-
-    const __m512i perm_lo = stepwise_permute<0>();
-    const __m512i perm_med = stepwise_permute<16>();
-    const __m512i perm_hi = stepwise_permute<32>();
-
-    static constexpr auto mask_med = make_loadmask<16>();
-    static constexpr auto mask_hi = make_loadmask<32>();
-};
-
-static const     auto Ys_perm_lo = make_permute<0, 7, 2, 9, 4, 11, 6, 13, 8, 15, 10, 0, 12, 0, 14, 0>();
-static constexpr auto Ys_mask_hi = make_bitmask<0, 0, 0, 0, 0,  0, 0,  0, 0,  0,  0, 1,  0, 1,  0, 1>();
-static const     auto Ys_perm_hi = make_permute<0, 0, 0, 0, 0,  0, 0,  0, 0,  0,  0, 1,  0, 3,  0, 5>();
-
-static const     auto pairwise_broadcast_perm_lo = make_permute<0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7>();
-static const     auto pairwise_broadcast_perm_hi = make_permute<8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15, 15>();
-
-static const StepwiseGather<1> G1;
-static const StepwiseGather<2> G2;
-static const StepwiseGather<3> G3;
-static const StepwiseGather<4> G4;
-static const StepwiseGather<5> G5;
-static const StepwiseGather<6> G6;
-
-KEWB_FORCE_INLINE
-static void sort(rf512& l, rf512& r)
-{
-    rf512 tmp = minimum(l, r);
-    r = maximum(l, r);
-    l = tmp;
-}
-
-KEWB_FORCE_INLINE
-static void process32(rf512& lo, rf512 med, rf512& hi)
-{
-    rf512 Ys_lo = permute(lo, Ys_perm_lo);
-    Ys_lo = mask_permute(Ys_lo, med, Ys_perm_hi, Ys_mask_hi);
-    rf512 Ys_hi = permute(med, Ys_perm_lo);
-    Ys_hi = mask_permute(Ys_hi, hi, Ys_perm_hi, Ys_mask_hi);
-
-    rf512 s1 = G1(lo, med, hi);
-    rf512 s2 = G2(lo, med, hi);
-    rf512 s3 = G3(lo, med, hi);
-    rf512 s4 = G4(lo, med, hi);
-    rf512 s5 = G5(lo, med, hi);
-    rf512 s6 = G6(lo, med, hi);
-    sort(s1, s2); sort(s3, s4); sort(s5, s6);
-    sort(s1, s3); sort(s2, s5); sort(s4, s6);
-    s2 = maximum(s1, s2); sort(s3, s4); s5 = minimum(s5, s6);
-    s3 = maximum(s2, s3); s4 = minimum(s4, s5);
-    sort(s3, s4);
-
-    rf512 tmp = permute(s3, pairwise_broadcast_perm_lo);
-    Ys_lo = maximum(Ys_lo, tmp);
-    tmp = permute(s4, pairwise_broadcast_perm_lo);
-    lo = minimum(Ys_lo, tmp);
-
-    tmp = permute(s3, pairwise_broadcast_perm_hi);
-    Ys_hi = maximum(Ys_hi, tmp);
-    tmp = permute(s4, pairwise_broadcast_perm_hi);
-    hi = minimum(Ys_hi, tmp);
-}
-
-void median_Parallel_step1(const float* psrc, float* pdst, size_t buf_len)
-{
-    __m512      prev;   //- Bottom of the input data window
-    __m512      curr_lo, curr_hi;   //- Middle of the input data window
-    __m512      next;   //- Top of the input data window
-    __m512      lo, med, hi;
-    m512        mask;   //- Trailing boundary mask
-
-    if (buf_len == 0)
-        return;
-    if (buf_len == 1)
-    {
-        *pdst = *psrc;
-        return;
-    }
-
-    rf512 const     first = load_value(psrc[0]);
-    rf512 const     last = load_value(psrc[buf_len - 1]);
-
-    if (buf_len < 16)
-    {
-        prev = first;
-        mask = ~(0xffffffff << buf_len);
-        curr_lo = masked_load_from(psrc, last, mask);
-        curr_hi = next = last;
-
-        lo = shift_up_with_carry<3>(prev, curr_lo);
-        med = shift_up_with_carry<3>(curr_lo, curr_hi);
-        hi = shift_up_with_carry<3>(curr_hi, next);
-
-        process32(lo, med, hi);
-        masked_store_to(pdst, lo, mask);
-        return;
-    }
-
-    curr_hi = first;
-    next = load_from(psrc); psrc += 16; buf_len -= 16;
-    
-    while(buf_len >= 32)
-    {
-        prev = curr_hi;
-        curr_lo = next;
-        curr_hi = load_from(psrc); psrc += 16;
-        next = load_from(psrc); psrc += 16;
-
-        lo = shift_up_with_carry<3>(prev, curr_lo);
-        med = shift_up_with_carry<3>(curr_lo, curr_hi);
-        hi = shift_up_with_carry<3>(curr_hi, next);
-
-        process32(lo, med, hi);
-
-        store_to_address(pdst, lo); pdst += 16;
-        store_to_address(pdst, hi); pdst += 16;
-        buf_len -= 32;
-    }
-
-    prev = curr_hi;
-    curr_lo = next;
-    if (buf_len >= 16)
-    {
-        curr_hi = load_from(psrc); psrc += 16; buf_len -= 16;
-        mask = ~(0xffffffff << buf_len);
-        next = masked_load_from(psrc, last, mask);
-
-        lo = shift_up_with_carry<3>(prev, curr_lo);
-        med = shift_up_with_carry<3>(curr_lo, curr_hi);
-        hi = shift_up_with_carry<3>(curr_hi, next);
-
-        process32(lo, med, hi);
-
-        store_to_address(pdst, lo); pdst += 16;
-        store_to_address(pdst, hi); pdst += 16;
-
-        if (buf_len > 0)
-        {
-            prev = curr_hi;
-            curr_lo = next;
-            curr_hi = next = last;
-
-            lo = shift_up_with_carry<3>(prev, curr_lo);
-            med = shift_up_with_carry<3>(curr_lo, curr_hi);
-            hi = shift_up_with_carry<3>(curr_hi, next);
-
-            process32(lo, med, hi);
-            masked_store_to(pdst, lo, mask);
-        }
-    }
-    else
-    {
-        mask = ~(0xffffffff << buf_len);
-        curr_hi = masked_load_from(psrc, last, mask);
-        next = last;
-
-        lo = shift_up_with_carry<3>(prev, curr_lo);
-        med = shift_up_with_carry<3>(curr_lo, curr_hi);
-        hi = shift_up_with_carry<3>(curr_hi, next);
-
-        process32(lo, med, hi);
-
-        store_to_address(pdst, lo); pdst += 16;
-        masked_store_to(pdst, hi, mask);
-    }
-}
+#include "avx-median.h"
+#include "output_writer.h"
+#include "stepwise_gather.h"
+
+static const     auto Ys_perm_lo = make_permute<0, 7, 2, 9, 4, 11, 6, 13, 8, 15, 10, 0, 12, 0, 14, 0>();
+static constexpr auto Ys_mask_hi = make_bitmask<0, 0, 0, 0, 0,  0, 0,  0, 0,  0,  0, 1,  0, 1,  0, 1>();
+static const     auto Ys_perm_hi = make_permute<0, 0, 0, 0, 0,  0, 0,  0, 0,  0,  0, 1,  0, 3,  0, 5>();
+
+static const     auto pairwise_broadcast_perm_lo = make_permute<0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7>();
+static const     auto pairwise_broadcast_perm_hi = make_permute<8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15, 15>();
+
+static const StepwiseGather<1> G1;
+static const StepwiseGather<2> G2;
+static const StepwiseGather<3> G3;
+static const StepwiseGather<4> G4;
+static const StepwiseGather<5> G5;
+static const StepwiseGather<6> G6;
+
+KEWB_FORCE_INLINE
+static void sort(rf512& l, rf512& r)
+{
+    rf512 tmp = minimum(l, r);
+    r = maximum(l, r);
+    l = tmp;
+}
+
+KEWB_FORCE_INLINE
+static void process32(rf512& lo, rf512 med, rf512& hi)
+{
+    rf512 Ys_lo = permute(lo, Ys_perm_lo);
+    Ys_lo = mask_permute(Ys_lo, med, Ys_perm_hi, Ys_mask_hi);
+    rf512 Ys_hi = permute(med, Ys_perm_lo);
+    Ys_hi = mask_permute(Ys_hi, hi, Ys_perm_hi, Ys_mask_hi);
+
+    rf512 s1 = G1(lo, med, hi);
+    rf512 s2 = G2(lo, med, hi);
+    rf512 s3 = G3(lo, med, hi);
+    rf512 s4 = G4(lo, med, hi);
+    rf512 s5 = G5(lo, med, hi);
+    rf512 s6 = G6(lo, med, hi);
+    sort(s1, s2); sort(s3, s4); sort(s5, s6);
+    sort(s1, s3); sort(s2, s5); sort(s4, s6);
+    s2 = maximum(s1, s2); sort(s3, s4); s5 = minimum(s5, s6);
+    s3 = maximum(s2, s3); s4 = minimum(s4, s5);
+    sort(s3, s4);
+
+    rf512 tmp = permute(s3, pairwise_broadcast_perm_lo);
+    Ys_lo = maximum(Ys_lo, tmp);
+    tmp = permute(s4, pairwise_broadcast_perm_lo);
+    lo = minimum(Ys_lo, tmp);
+
+    tmp = permute(s3, pairwise_broadcast_perm_hi);
+    Ys_hi = maximum(Ys_hi, tmp);
+    tmp = permute(s4, pairwise_broadcast_perm_hi);
+    hi = minimum(Ys_hi, tmp);
+}
+
+//- When 'Aligned', 'psrc' is 64-byte aligned and the first 'lead' (< 16) samples before the
+//  real input are stand-ins for its first element (so that edge replication is unchanged); the
+//  main loop uses aligned loads and prefetches 'prefetch' samples ahead. Otherwise 'lead' is 0.
+//
+template<bool Aligned, typename Writer>
+static void filter_step1(const float* psrc, Writer out, size_t buf_len, size_t lead, size_t prefetch)
+{
+    __m512      prev;   //- Bottom of the input data window
+    __m512      curr_lo, curr_hi;   //- Middle of the input data window
+    __m512      next;   //- Top of the input data window
+    __m512      lo, med, hi;
+    m512        mask;   //- Trailing boundary mask
+
+    rf512 const     first = load_value(psrc[lead]);
+    rf512 const     last = load_value(psrc[buf_len - 1]);
+
+    if (buf_len < 16)
+    {
+        prev = first;
+        mask = ~(0xffffffff << buf_len);
+        curr_lo = masked_load_from(psrc, last, mask);
+        curr_hi = next = last;
+
+        lo = shift_up_with_carry<3>(prev, curr_lo);
+        med = shift_up_with_carry<3>(curr_lo, curr_hi);
+        hi = shift_up_with_carry<3>(curr_hi, next);
+
+        process32(lo, med, hi);
+        out.put_last(lo, buf_len);
+        return;
+    }
+
+    curr_hi = first;
+    next = masked_load_from(psrc, first, 0xFFFFu << lead); psrc += 16; buf_len -= 16;
+    
+    while(buf_len >= 32)
+    {
+        prev = curr_hi;
+        curr_lo = next;
+        if constexpr (Aligned)
+        {
+            _mm_prefetch((const char*)(psrc + prefetch), _MM_HINT_T0);
+            _mm_prefetch((const char*)(psrc + prefetch + 16), _MM_HINT_T0);
+            curr_hi = _mm512_load_ps(psrc); psrc += 16;
+            next = _mm512_load_ps(psrc); psrc += 16;
+        }
+        else
+        {
+            curr_hi = load_from(psrc); psrc += 16;
+            next = load_from(psrc); psrc += 16;
+        }
+
+        lo = shift_up_with_carry<3>(prev, curr_lo);
+        med = shift_up_with_carry<3>(curr_lo, curr_hi);
+        hi = shift_up_with_carry<3>(curr_hi, next);
+
+        process32(lo, med, hi);
+
+        out.put(lo);
+        out.put(hi);
+        buf_len -= 32;
+    }
+
+    prev = curr_hi;
+    curr_lo = next;
+    if (buf_len >= 16)
+    {
+        curr_hi = load_from(psrc); psrc += 16; buf_len -= 16;
+        mask = ~(0xffffffff << buf_len);
+        next = masked_load_from(psrc, last, mask);
+
+        lo = shift_up_with_carry<3>(prev, curr_lo);
+        med = shift_up_with_carry<3>(curr_lo, curr_hi);
+        hi = shift_up_with_carry<3>(curr_hi, next);
+
+        process32(lo, med, hi);
+
+        out.put(lo);
+
+        if (buf_len > 0)
+        {
+            out.put(hi);
+
+            prev = curr_hi;
+            curr_lo = next;
+            curr_hi = next = last;
+
+            lo = shift_up_with_carry<3>(prev, curr_lo);
+            med = shift_up_with_carry<3>(curr_lo, curr_hi);
+            hi = shift_up_with_carry<3>(curr_hi, next);
+
+            process32(lo, med, hi);
+            out.put_last(lo, buf_len);
+        }
+        else
+        {
+            out.put_last(hi, 16);
+        }
+    }
+    else
+    {
+        mask = ~(0xffffffff << buf_len);
+        curr_hi = masked_load_from(psrc, last, mask);
+        next = last;
+
+        lo = shift_up_with_carry<3>(prev, curr_lo);
+        med = shift_up_with_carry<3>(curr_lo, curr_hi);
+        hi = shift_up_with_carry<3>(curr_hi, next);
+
+        process32(lo, med, hi);
+
+        out.put(lo);
+        out.put_last(hi, buf_len);
+    }
+}
+
+void median_Parallel_step1(const float* psrc, float* pdst, size_t buf_len)
+{
+    median_Parallel_step1(psrc, pdst, buf_len, buf_len >= median_streaming_threshold);
+}
+
+void median_Parallel_step1(const float* psrc, float* pdst, size_t buf_len, bool streaming)
+{
+    if (buf_len == 0)
+        return;
+    if (buf_len == 1)
+    {
+        *pdst = *psrc;
+        return;
+    }
+
+    if (streaming)
+    {
+        filter_step1<false>(psrc, StreamingWriter(pdst), buf_len, 0, 0);
+    }
+    else
+    {
+        filter_step1<false>(psrc, CachedWriter(pdst), buf_len, 0, 0);
+    }
+}
+
+void median_Parallel_step1_aligned(const float* psrc, float* pdst, size_t buf_len)
+{
+    median_Parallel_step1_aligned(psrc, pdst, buf_len, median_prefetch_distance);
+}
+
+void median_Parallel_step1_aligned(const float* psrc, float* pdst, size_t buf_len, size_t prefetch_distance)
+{
+    //- Peel to the preceding 64-byte boundary: the peeled lanes hold copies of the first sample,
+    //  and their outputs are never stored.
+    //
+    size_t const    lead = ((uintptr_t)psrc / sizeof(float)) % 16;
+
+    if (buf_len < 64)
+    {
+        median_Parallel_step1(psrc, pdst, buf_len);
+    }
+    else
+    {
+        filter_step1<true>(psrc - lead, SkippingWriter(pdst, lead), buf_len + lead, lead, prefetch_distance);
+    }
+}
+
+//- Hampel filter on the medians of process32: the 7 taps of each output are still in 'lo | med |
+//  hi', so the deviations from the median and their median (the MAD) are computed in registers,
+//  16 outputs at a time with the 7-input median network of median_Parallel, and the samples
+//  beyond 'threshold' times the scaled MAD are replaced in the same pass.
+//
+KEWB_FORCE_INLINE
+static rf512 median_of_7(rf512 s1, rf512 s2, rf512 s3, rf512 s4, rf512 s5, rf512 s6, rf512 s7)
+{
+    sort(s2, s3); sort(s4, s5); sort(s6, s7);
+    sort(s1, s3); sort(s5, s7); sort(s4, s6);
+    s3 = minimum(s3, s7); sort(s2, s6); sort(s1, s5);
+    s3 = minimum(s3, s6); s4 = maximum(s4, s1);
+    s3 = minimum(s3, s5); s4 = maximum(s2, s4);
+    return maximum(s3, s4);
+}
+
+KEWB_FORCE_INLINE
+static rf512 deviation(rf512 sample, rf512 median)
+{
+    return _mm512_abs_ps(_mm512_sub_ps(sample, median));
+}
+
+//- 'lo | hi' holds taps 0 .. 6 of output 'o' at 'o' .. 'o' + 6; returns the cleaned outputs and
+//  sets 'outliers' to the lanes that were replaced.
+//
+KEWB_FORCE_INLINE
+static rf512 hampel16(rf512 lo, rf512 hi, rf512 median, rf512 scale, __mmask16& outliers)
+{
+    rf512 const     sample = shift_up_with_carry<13>(lo, hi);
+    rf512 const     mad = median_of_7(deviation(lo, median),
+                                      deviation(shift_up_with_carry<15>(lo, hi), median),
+                                      deviation(shift_up_with_carry<14>(lo, hi), median),
+                                      deviation(sample, median),
+                                      deviation(shift_up_with_carry<12>(lo, hi), median),
+                                      deviation(shift_up_with_carry<11>(lo, hi), median),
+                                      deviation(shift_up_with_carry<10>(lo, hi), median));
+
+    outliers = _mm512_cmp_ps_mask(deviation(sample, median), _mm512_mul_ps(scale, mad), _CMP_GT_OQ);
+    return _mm512_mask_mov_ps(sample, outliers, median);
+}
+
+void hampel_filter(const float* psrc, float* pdst, size_t buf_len, float threshold, uint8_t* outliers)
+{
+    __m512      prev;   //- Bottom of the input data window
+    __m512      curr_lo, curr_hi;   //- Middle of the input data window
+    __m512      next;   //- Top of the input data window
+    __m512      lo, med, hi;
+    __mmask16   outliers_lo, outliers_hi;
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    rf512 const     first = load_value(psrc[0]);
+    rf512 const     last = load_value(psrc[buf_len - 1]);
+    rf512 const     scale = load_value(threshold * hampel_mad_scale);
+    CachedWriter    out(pdst);
+
+    prev = first;
+    curr_lo = load_clamped(psrc, 0, buf_len, last);
+    curr_hi = load_clamped(psrc, 16, buf_len, last);
+
+    //- Each block of 32 outputs is stored after all the input it depends on has been read, so
+    //  'pdst' may equal 'psrc'.
+    //
+    for (size_t wrote = 0; wrote < buf_len; wrote += 32)
+    {
+        next = load_clamped(psrc, wrote + 32, buf_len, last);
+
+        lo = shift_up_with_carry<3>(prev, curr_lo);
+        med = shift_up_with_carry<3>(curr_lo, curr_hi);
+        hi = shift_up_with_carry<3>(curr_hi, next);
+
+        rf512   median_lo = lo;
+        rf512   median_hi = hi;
+
+        process32(median_lo, med, median_hi);
+
+        rf512 const     data_lo = hampel16(lo, med, median_lo, scale, outliers_lo);
+        rf512 const     data_hi = hampel16(med, hi, median_hi, scale, outliers_hi);
+
+        if (wrote + 32 <= buf_len)
+        {
+            out.put(data_lo);
+            out.put(data_hi);
+        }
+        else if (wrote + 16 <= buf_len)
+        {
+            out.put(data_lo);
+            out.put_last(data_hi, buf_len - wrote - 16);
+        }
+        else
+        {
+            out.put_last(data_lo, buf_len - wrote);
+        }
+
+        if (outliers != nullptr)
+        {
+            uint32_t const  bits = (uint32_t)outliers_lo | (uint32_t)outliers_hi << 16;
+            size_t const    count = std::min<size_t>(32, buf_len - wrote);
+
+            for (size_t i = 0; i < (count + 7) / 8; ++i)
+            {
+                outliers[wrote / 8 + i] = (uint8_t)((bits & (0xffffffffu >> (32 - count))) >> (8 * i));
+            }
+        }
+
+        prev = curr_hi;
+        curr_lo = next;
+        curr_hi = load_clamped(psrc, wrote + 48, buf_len, last);
+    }
+}
@@ -0,0 +1,148 @@
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+#ifdef __linux__
+
+struct EventConfig
+{
+    uint32_t    type;
+    uint64_t    config;
+    bool        intel_only;
+};
+
+constexpr uint64_t  cache_read_miss(uint64_t cache)
+{
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+//- Raw events are encoded as umask << 8 | event select.
+//
+constexpr EventConfig   event_configs[PerfCounters::event_count] =
+{
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, false },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, false },
+    { PERF_TYPE_RAW, 0x010e, true },                                    //- UOPS_ISSUED.ANY
+    { PERF_TYPE_RAW, 0x20a1, true },                                    //- UOPS_DISPATCHED_PORT.PORT_5
+    { PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_L1D), false },
+    { PERF_TYPE_RAW, 0x3f24, true },                                    //- L2_RQSTS.MISS
+    { PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_LL), false },
+};
+
+int open_event(const EventConfig& event)
+{
+    perf_event_attr     attr;
+
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+#endif
+
+}   // namespace
+
+#ifdef __linux__
+
+PerfCounters::PerfCounters()
+{
+    bool const  intel = __builtin_cpu_is("intel");
+
+    for (size_t i = 0; i < event_count; ++i)
+    {
+        m_fds[i] = (intel || !event_configs[i].intel_only) ? open_event(event_configs[i]) : -1;
+    }
+    m_values.fill(0.0);
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+void PerfCounters::start()
+{
+    for (int fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void PerfCounters::stop()
+{
+    for (int fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (size_t i = 0; i < event_count; ++i)
+    {
+        uint64_t    counts[3] = {};     //- Value, time enabled, time running
+
+        m_values[i] = 0.0;
+        if (m_fds[i] >= 0 && read(m_fds[i], counts, sizeof(counts)) == sizeof(counts) && counts[2] != 0)
+        {
+            m_values[i] = (double)counts[0] * ((double)counts[1] / (double)counts[2]);
+        }
+    }
+}
+
+#else
+
+PerfCounters::PerfCounters()
+{
+    m_fds.fill(-1);
+    m_values.fill(0.0);
+}
+
+PerfCounters::~PerfCounters()
+{}
+
+void PerfCounters::start()
+{}
+
+void PerfCounters::stop()
+{}
+
+#endif
+
+bool PerfCounters::any_available() const
+{
+    for (int fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+//- Hardware event counters for the calling thread, read through perf_event_open(2) on Linux; on
+//  other systems, or where the kernel refuses access (perf_event_paranoid > 2, no PMU in a VM),
+//  no event is available and start()/stop() do nothing. Only user-mode events are counted, and
+//  only on the calling thread, so the thread pool's workers are not included.
+//
+//  Every event is opened on its own, so that the kernel multiplexes them when there are more
+//  events than counters; values are scaled by the fraction of time each was actually counting.
+//
+class PerfCounters
+{
+public:
+    enum Event
+    {
+        Cycles,
+        Instructions,
+        Uops,           //- Uops issued (Intel only)
+        Port5Uops,      //- Uops dispatched to port 5, the shuffle port (Intel Skylake encoding)
+        L1DMisses,      //- L1D read misses
+        L2Misses,       //- L2 requests that missed (Intel Skylake encoding)
+        LLCMisses,      //- Last level cache read misses
+        event_count
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool    available(Event event) const    { return m_fds[event] >= 0; }
+    bool    any_available() const;
+
+    //- Resets and enables the counters; stop() disables them and latches the counts since start().
+    //
+    void    start();
+    void    stop();
+
+    double  value(Event event) const        { return m_values[event]; }
+
+private:
+    std::array<int, event_count>    m_fds;
+    std::array<double, event_count> m_values;
+};
@@ -0,0 +1,70 @@
+#include "rank_filter.h"
+
+template void rank_filter<3, 0>(const float*, float*, size_t);
+template void rank_filter<3, 1>(const float*, float*, size_t);
+template void rank_filter<3, 2>(const float*, float*, size_t);
+template void rank_filter<5, 0>(const float*, float*, size_t);
+template void rank_filter<5, 1>(const float*, float*, size_t);
+template void rank_filter<5, 2>(const float*, float*, size_t);
+template void rank_filter<5, 3>(const float*, float*, size_t);
+template void rank_filter<5, 4>(const float*, float*, size_t);
+template void rank_filter<7, 0>(const float*, float*, size_t);
+template void rank_filter<7, 1>(const float*, float*, size_t);
+template void rank_filter<7, 2>(const float*, float*, size_t);
+template void rank_filter<7, 3>(const float*, float*, size_t);
+template void rank_filter<7, 4>(const float*, float*, size_t);
+template void rank_filter<7, 5>(const float*, float*, size_t);
+template void rank_filter<7, 6>(const float*, float*, size_t);
+template void rank_filter<9, 0>(const float*, float*, size_t);
+template void rank_filter<9, 1>(const float*, float*, size_t);
+template void rank_filter<9, 2>(const float*, float*, size_t);
+template void rank_filter<9, 3>(const float*, float*, size_t);
+template void rank_filter<9, 4>(const float*, float*, size_t);
+template void rank_filter<9, 5>(const float*, float*, size_t);
+template void rank_filter<9, 6>(const float*, float*, size_t);
+template void rank_filter<9, 7>(const float*, float*, size_t);
+template void rank_filter<9, 8>(const float*, float*, size_t);
+template void rank_filter<11, 0>(const float*, float*, size_t);
+template void rank_filter<11, 1>(const float*, float*, size_t);
+template void rank_filter<11, 2>(const float*, float*, size_t);
+template void rank_filter<11, 3>(const float*, float*, size_t);
+template void rank_filter<11, 4>(const float*, float*, size_t);
+template void rank_filter<11, 5>(const float*, float*, size_t);
+template void rank_filter<11, 6>(const float*, float*, size_t);
+template void rank_filter<11, 7>(const float*, float*, size_t);
+template void rank_filter<11, 8>(const float*, float*, size_t);
+template void rank_filter<11, 9>(const float*, float*, size_t);
+template void rank_filter<11, 10>(const float*, float*, size_t);
+template void rank_filter<13, 0>(const float*, float*, size_t);
+template void rank_filter<13, 1>(const float*, float*, size_t);
+template void rank_filter<13, 2>(const float*, float*, size_t);
+template void rank_filter<13, 3>(const float*, float*, size_t);
+template void rank_filter<13, 4>(const float*, float*, size_t);
+template void rank_filter<13, 5>(const float*, float*, size_t);
+template void rank_filter<13, 6>(const float*, float*, size_t);
+template void rank_filter<13, 7>(const float*, float*, size_t);
+template void rank_filter<13, 8>(const float*, float*, size_t);
+template void rank_filter<13, 9>(const float*, float*, size_t);
+template void rank_filter<13, 10>(const float*, float*, size_t);
+template void rank_filter<13, 11>(const float*, float*, size_t);
+template void rank_filter<13, 12>(const float*, float*, size_t);
+template void rank_filter<15, 0>(const float*, float*, size_t);
+template void rank_filter<15, 1>(const float*, float*, size_t);
+template void rank_filter<15, 2>(const float*, float*, size_t);
+template void rank_filter<15, 3>(const float*, float*, size_t);
+template void rank_filter<15, 4>(const float*, float*, size_t);
+template void rank_filter<15, 5>(const float*, float*, size_t);
+template void rank_filter<15, 6>(const float*, float*, size_t);
+template void rank_filter<15, 7>(const float*, float*, size_t);
+template void rank_filter<15, 8>(const float*, float*, size_t);
+template void rank_filter<15, 9>(const float*, float*, size_t);
+template void rank_filter<15, 10>(const float*, float*, size_t);
+template void rank_filter<15, 11>(const float*, float*, size_t);
+template void rank_filter<15, 12>(const float*, float*, size_t);
+template void rank_filter<15, 13>(const float*, float*, size_t);
+template void rank_filter<15, 14>(const float*, float*, size_t);
+
+template void rank_filter<7, 0, 3, 6>(const float*, float* const*, size_t);
+template void rank_filter<9, 0, 4, 8>(const float*, float* const*, size_t);
+template void rank_filter<11, 0, 1, 5, 9, 10>(const float*, float* const*, size_t);
+template void rank_filter<15, 0, 1, 7, 13, 14>(const float*, float* const*, size_t);
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "avx-median.h"
+#include "output_writer.h"
+#include "selection_network.h"
+#include "stepwise_gather.h"
+
+#include <utility>
+
+//- Rank-order filter over a window of W = 2 * R + 1 taps, on the layout of median_Parallel_step1:
+//  each iteration filters 32 outputs held in 'lo | med | hi', shifted up by R so that output 'o'
+//  sees taps 'o' .. 'o + W - 1'. Outputs 2p and 2p + 1 share the W - 1 taps 2p + 1 .. 2p + W - 1;
+//  one register gathers tap 'Offset' of each of the 16 pairs, and the pruned network keeps only
+//  ranks K - 1 and K of the shared taps. Each output then adds the tap the pair does not share:
+//  rank K of the window is that tap clamped to [rank K - 1, rank K] of the shared ones. Several
+//  ranks run through the same network, which keeps the union of the ranks they need.
+//
+//  rank_filter.cpp instantiates every single rank and the rank sets listed in avx-median.h; a
+//  translation unit compiled for AVX-512 includes this header to instantiate other rank sets.
+//
+namespace rank_filter_detail
+{
+
+template<int W, int K>
+constexpr size_t    lower_rank = (K == 0) ? 0 : K - 1;
+
+template<int W, int K>
+constexpr size_t    upper_rank = (K == W - 1) ? W - 2 : K;
+
+//- Per lane 'l' of an output register, the tap the pair of 'l' does not share: tap 'l' for an
+//  even output, tap 'l + W - 1' for an odd one, read from the register and the one above it.
+//
+template<int W, int... L>
+KEWB_FORCE_INLINE __m512i
+    unshared_taps(std::integer_sequence<int, L...>)
+{
+    return load_values<(L + ((L & 1) ? W - 1 : 0))...>();
+}
+
+KEWB_FORCE_INLINE __m512i
+    pairwise_broadcast_lo()
+{
+    return make_permute<0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7>();
+}
+
+KEWB_FORCE_INLINE __m512i
+    pairwise_broadcast_hi()
+{
+    return make_permute<8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15, 15>();
+}
+
+template<int W, int K>
+KEWB_FORCE_INLINE rf512
+    select_rank(rf512 const* shared, rf512 unshared, __m512i broadcast)
+{
+    if constexpr (K == 0)
+    {
+        return minimum(unshared, permute(shared[upper_rank<W, K>], broadcast));
+    }
+    else if constexpr (K == W - 1)
+    {
+        return maximum(unshared, permute(shared[lower_rank<W, K>], broadcast));
+    }
+    else
+    {
+        rf512 const     upper = minimum(unshared, permute(shared[upper_rank<W, K>], broadcast));
+
+        return maximum(permute(shared[lower_rank<W, K>], broadcast), upper);
+    }
+}
+
+template<int W, int... K, int... Offset>
+KEWB_FORCE_INLINE void
+    process32(rf512 lo, rf512 med, rf512 hi, rf512* out_lo, rf512* out_hi, std::integer_sequence<int, Offset...>)
+{
+    using rank_network = selection_network<W - 1, lower_rank<W, K>..., upper_rank<W, K>...>;
+
+    rf512   shared[] = { StepwiseGather<Offset + 1>()(lo, med, hi)... };
+
+    apply_network<rank_network>(shared);
+
+    __m512i const   taps = unshared_taps<W>(std::make_integer_sequence<int, 16>());
+    rf512 const     unshared_lo = _mm512_permutex2var_ps(lo, taps, med);
+    rf512 const     unshared_hi = _mm512_permutex2var_ps(med, taps, hi);
+    size_t          i = 0;
+
+    ((out_lo[i] = select_rank<W, K>(shared, unshared_lo, pairwise_broadcast_lo()),
+      out_hi[i] = select_rank<W, K>(shared, unshared_hi, pairwise_broadcast_hi()), ++i), ...);
+}
+
+}   // namespace rank_filter_detail
+
+template<int W, int... K>
+void rank_filter(const float* psrc, float* const* pdsts, size_t buf_len)
+{
+    static_assert(W % 2 == 1 && W >= 3 && W <= 15, "the shared taps must fit StepwiseGather");
+    static_assert(sizeof...(K) > 0 && ((K >= 0 && K < W) && ...), "");
+
+    constexpr int       R = W / 2;
+    constexpr size_t    ranks = sizeof...(K);
+
+    __m512      prev;           //- Bottom of the input data window
+    __m512      curr_lo;        //- Middle of the input data window
+    __m512      curr_hi;
+    __m512      next;           //- Top of the input data window
+    __m512      out_lo[ranks];  //- Outputs 0 .. 15 of each rank
+    __m512      out_hi[ranks];  //- Outputs 16 .. 31 of each rank
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    rf512 const     first = load_value(psrc[0]);
+    rf512 const     last = load_value(psrc[buf_len - 1]);
+
+    //- Each block of 32 outputs is stored after all the input it depends on has been read, so
+    //  one of 'pdsts' may equal 'psrc'.
+    //
+    prev = first;
+    curr_lo = load_clamped(psrc, 0, buf_len, last);
+    curr_hi = load_clamped(psrc, 16, buf_len, last);
+
+    for (size_t wrote = 0; wrote < buf_len; wrote += 32)
+    {
+        next = load_clamped(psrc, wrote + 32, buf_len, last);
+
+        rank_filter_detail::process32<W, K...>(shift_up_with_carry<R>(prev, curr_lo),
+                                               shift_up_with_carry<R>(curr_lo, curr_hi),
+                                               shift_up_with_carry<R>(curr_hi, next),
+                                               out_lo, out_hi, std::make_integer_sequence<int, W - 1>());
+
+        for (size_t i = 0; i < ranks; ++i)
+        {
+            store_clamped(pdsts[i], wrote, buf_len, out_lo[i]);
+            store_clamped(pdsts[i], wrote + 16, buf_len, out_hi[i]);
+        }
+
+        prev = curr_hi;
+        curr_lo = next;
+        curr_hi = load_clamped(psrc, wrote + 48, buf_len, last);
+    }
+}
+
+template<int W, int K>
+void rank_filter(const float* psrc, float* pdst, size_t buf_len)
+{
+    rank_filter<W, K>(psrc, &pdst, buf_len);
+}
@@ -0,0 +1,228 @@
+#include "avx-median.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+//- Sliding-window median over a double heap: a max-heap holding the 'radius' values below the
+//  median, the median itself, and a min-heap holding the 'radius' values above it. The window
+//  is a FIFO of slots; each slot remembers where its value currently lives in the heaps, so the
+//  oldest value can be replaced in place and the heaps repaired in O(log W).
+//
+//  Positions are encoded as 0 for the median, +i for entry i of the upper heap and -i for
+//  entry i of the lower heap (heaps are 1-based, children of i are 2i and 2i + 1).
+//
+class RunningMedian
+{
+public:
+    RunningMedian(size_t radius)
+    :   m_radius(radius),
+        m_values(2 * radius + 1),
+        m_position(2 * radius + 1),
+        m_lower(radius + 1),
+        m_upper(radius + 1)
+    {}
+
+    //- Fills the window from 'psrc[0 .. 2 * radius]' and lays it out as a sorted double heap.
+    //
+    void reset(const float* psrc)
+    {
+        std::vector<uint32_t>   order(m_values.size());
+
+        std::copy(psrc, psrc + m_values.size(), m_values.begin());
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return m_values[a] < m_values[b]; });
+
+        for (size_t i = 1; i <= m_radius; ++i)
+        {
+            place(-(ptrdiff_t)i, order[m_radius - i]);
+            place((ptrdiff_t)i, order[m_radius + i]);
+        }
+        place(0, order[m_radius]);
+        m_oldest = 0;
+    }
+
+    //- Replaces the oldest value of the window with 'value'.
+    //
+    void push(float value)
+    {
+        uint32_t const      slot = m_oldest;
+        ptrdiff_t const     p = m_position[slot];
+        float const         old = m_values[slot];
+
+        m_oldest = (slot + 1 == m_values.size()) ? 0 : slot + 1;
+        m_values[slot] = value;
+
+        if (p > 0)
+        {
+            if (old < value)
+            {
+                sift_down_upper(p);
+            }
+            else if (sift_up_upper(p) && value_at(1) < median())
+            {
+                swap_entries(1, 0);
+                sift_down_upper(1);
+                if (median() < value_at(-1))
+                {
+                    swap_entries(-1, 0);
+                    sift_down_lower(1);
+                }
+            }
+        }
+        else if (p < 0)
+        {
+            if (value < old)
+            {
+                sift_down_lower(-p);
+            }
+            else if (sift_up_lower(-p) && median() < value_at(-1))
+            {
+                swap_entries(-1, 0);
+                sift_down_lower(1);
+                if (value_at(1) < median())
+                {
+                    swap_entries(1, 0);
+                    sift_down_upper(1);
+                }
+            }
+        }
+        else if (m_radius > 0)
+        {
+            if (value < value_at(-1))
+            {
+                swap_entries(-1, 0);
+                sift_down_lower(1);
+            }
+            else if (value_at(1) < value)
+            {
+                swap_entries(1, 0);
+                sift_down_upper(1);
+            }
+        }
+    }
+
+    float median() const
+    {
+        return m_values[m_median];
+    }
+
+private:
+    uint32_t& entry(ptrdiff_t p)
+    {
+        return (p > 0) ? m_upper[p] : (p < 0) ? m_lower[-p] : m_median;
+    }
+
+    float value_at(ptrdiff_t p)
+    {
+        return m_values[entry(p)];
+    }
+
+    void place(ptrdiff_t p, uint32_t slot)
+    {
+        entry(p) = slot;
+        m_position[slot] = p;
+    }
+
+    void swap_entries(ptrdiff_t a, ptrdiff_t b)
+    {
+        uint32_t const  slot_a = entry(a);
+        uint32_t const  slot_b = entry(b);
+
+        place(a, slot_b);
+        place(b, slot_a);
+    }
+
+    //- Moves the entry at upper heap index 'i' towards the root; returns true if it got there.
+    //
+    bool sift_up_upper(ptrdiff_t i)
+    {
+        for (; i > 1 && value_at(i) < value_at(i / 2); i /= 2)
+        {
+            swap_entries(i, i / 2);
+        }
+        return i == 1;
+    }
+
+    bool sift_up_lower(ptrdiff_t i)
+    {
+        for (; i > 1 && value_at(-(i / 2)) < value_at(-i); i /= 2)
+        {
+            swap_entries(-i, -(i / 2));
+        }
+        return i == 1;
+    }
+
+    void sift_down_upper(ptrdiff_t i)
+    {
+        ptrdiff_t const     size = (ptrdiff_t)m_radius;
+
+        for (ptrdiff_t child = 2 * i; child <= size; i = child, child = 2 * i)
+        {
+            if (child < size && value_at(child + 1) < value_at(child))
+            {
+                ++child;
+            }
+            if (!(value_at(child) < value_at(i)))
+            {
+                break;
+            }
+            swap_entries(i, child);
+        }
+    }
+
+    void sift_down_lower(ptrdiff_t i)
+    {
+        ptrdiff_t const     size = (ptrdiff_t)m_radius;
+
+        for (ptrdiff_t child = 2 * i; child <= size; i = child, child = 2 * i)
+        {
+            if (child < size && value_at(-child) < value_at(-(child + 1)))
+            {
+                ++child;
+            }
+            if (!(value_at(-i) < value_at(-child)))
+            {
+                break;
+            }
+            swap_entries(-i, -child);
+        }
+    }
+
+    size_t                  m_radius;
+    std::vector<float>      m_values;       //- Window contents, indexed by FIFO slot
+    std::vector<ptrdiff_t>  m_position;     //- Heap position of each slot
+    std::vector<uint32_t>   m_lower;        //- Max-heap of slots below the median
+    std::vector<uint32_t>   m_upper;        //- Min-heap of slots above the median
+    uint32_t                m_median = 0;   //- Slot holding the median
+    uint32_t                m_oldest = 0;   //- Slot to be replaced by the next push
+};
+
+//- Running median with an arbitrary odd 'window' (an even window is widened by one) and the
+//  same edge replication as median_Cpp. Costs O(log window) per output sample.
+//
+void median_Running(const float* psrc, float* pdst, size_t buf_len, size_t window)
+{
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    size_t const        radius = window / 2;
+    ptrdiff_t const     end = (ptrdiff_t)buf_len - 1;
+    RunningMedian       engine(radius);
+    std::vector<float>  initial(2 * radius + 1);
+
+    for (size_t i = 0; i < initial.size(); ++i)
+    {
+        initial[i] = psrc[std::clamp<ptrdiff_t>((ptrdiff_t)i - (ptrdiff_t)radius, 0, end)];
+    }
+    engine.reset(initial.data());
+    pdst[0] = engine.median();
+
+    for (ptrdiff_t pos = 1; pos <= end; ++pos)
+    {
+        engine.push(psrc[std::min<ptrdiff_t>(pos + (ptrdiff_t)radius, end)]);
+        pdst[pos] = engine.median();
+    }
+}
@@ -0,0 +1,111 @@
+#include "sample_arena.h"
+
+#include <new>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+static size_t round_up(size_t bytes, size_t granule)
+{
+    return (bytes + granule - 1) / granule * granule;
+}
+
+#ifdef _WIN32
+
+//- Large pages need the 'Lock pages in memory' privilege; without it the first VirtualAlloc
+//  fails and the arena uses regular pages.
+//
+SampleArena::SampleArena(size_t capacity, bool huge_pages)
+{
+    if (huge_pages && GetLargePageMinimum() != 0)
+    {
+        m_reserved = round_up(capacity, GetLargePageMinimum());
+        m_mapping = VirtualAlloc(nullptr, m_reserved, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        m_huge_pages = (m_mapping != nullptr);
+    }
+    if (m_mapping == nullptr)
+    {
+        m_reserved = capacity;
+        m_mapping = VirtualAlloc(nullptr, m_reserved, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+    if (m_mapping == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    m_base = static_cast<char*>(m_mapping);
+    m_capacity = m_reserved;
+}
+
+SampleArena::~SampleArena()
+{
+    VirtualFree(m_mapping, 0, MEM_RELEASE);
+}
+
+#else
+
+//- Explicit huge pages (MAP_HUGETLB) are tried first, since they are guaranteed once granted,
+//  but need a pool reserved by the administrator; otherwise the mapping is aligned to 2 MB by
+//  hand and marked for transparent huge pages.
+//
+SampleArena::SampleArena(size_t capacity, bool huge_pages)
+{
+    void* const     failed = MAP_FAILED;
+    size_t const    size = huge_pages ? round_up(capacity, huge_page_size) : capacity;
+
+    m_mapping = failed;
+#ifdef MAP_HUGETLB
+    if (huge_pages)
+    {
+        m_reserved = size;
+        m_mapping = mmap(nullptr, m_reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        m_huge_pages = (m_mapping != failed);
+    }
+#endif
+    if (m_mapping == failed)
+    {
+        m_reserved = huge_pages ? size + huge_page_size : size;
+        m_mapping = mmap(nullptr, m_reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (m_mapping == failed)
+    {
+        m_mapping = nullptr;
+        throw std::bad_alloc();
+    }
+
+    m_base = static_cast<char*>(m_mapping);
+    m_capacity = size;
+#ifdef MADV_HUGEPAGE
+    if (huge_pages && !m_huge_pages)
+    {
+        m_base = reinterpret_cast<char*>(round_up(reinterpret_cast<size_t>(m_mapping), huge_page_size));
+        m_huge_pages = (madvise(m_base, m_capacity, MADV_HUGEPAGE) == 0);
+    }
+#endif
+}
+
+SampleArena::~SampleArena()
+{
+    munmap(m_mapping, m_reserved);
+}
+
+#endif
+
+void* SampleArena::allocate_bytes(size_t bytes)
+{
+    size_t const    size = round_up(bytes, alignment);
+
+    if (size > m_capacity - m_used)
+    {
+        throw std::bad_alloc();
+    }
+
+    void* const     result = m_base + m_used;
+
+    m_used += size;
+    return result;
+}
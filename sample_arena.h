@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+
+//- A bump allocator for sample buffers. Every allocation starts on a 64-byte boundary, so that
+//  the kernels' 64-byte loads and stores never split a cache line, and the whole arena can be
+//  backed by 2 MB pages to cut TLB misses on DRAM-sized buffers. Memory is only returned all at
+//  once, by reset() or by destroying the arena.
+//
+class SampleArena
+{
+public:
+    static constexpr size_t     alignment = 64;
+    static constexpr size_t     huge_page_size = size_t(2) << 20;
+
+    //- Reserves 'capacity' bytes. With 'huge_pages', the arena is aligned to and sized in 2 MB
+    //  pages and asks the OS to back it with huge pages; if the OS declines, it silently falls
+    //  back to regular pages (see huge_pages()). Throws std::bad_alloc if nothing can be reserved.
+    //
+    explicit SampleArena(size_t capacity, bool huge_pages = false);
+    ~SampleArena();
+
+    SampleArena(const SampleArena&) = delete;
+    SampleArena& operator=(const SampleArena&) = delete;
+
+    //- Returns 'count' uninitialised, 64-byte aligned elements; throws std::bad_alloc when the
+    //  arena is exhausted.
+    //
+    template<typename T>
+    T*      allocate(size_t count)
+    {
+        return static_cast<T*>(allocate_bytes(count * sizeof(T)));
+    }
+
+    void    reset()             { m_used = 0; }
+
+    size_t  capacity() const    { return m_capacity; }
+    size_t  used() const        { return m_used; }
+
+    //- Whether the OS was asked for huge pages and accepted the request. With transparent huge
+    //  pages the kernel may still back parts of the arena with regular pages.
+    //
+    bool    huge_pages() const  { return m_huge_pages; }
+
+private:
+    void*   allocate_bytes(size_t bytes);
+
+    char*   m_base = nullptr;
+    size_t  m_capacity = 0;
+    size_t  m_used = 0;
+    size_t  m_reserved = 0;     //- Bytes obtained from the OS, starting at 'm_mapping'
+    void*   m_mapping = nullptr;
+    bool    m_huge_pages = false;
+};
@@ -0,0 +1,356 @@
+#pragma once
+
+#include "avx-median.h"
+
+#include <cstddef>
+#include <utility>
+
+//- Compile-time generation of pruned selection networks.
+//
+//  A full sorting network for N inputs is generated with Batcher's odd-even merge sort (the
+//  network for the next power of two, with every comparator that touches a wire >= N removed;
+//  those wires would only ever carry +inf). The network is then walked backwards from the
+//  requested output ranks, and every comparator whose results are never consumed is dropped.
+//  Comparators for which only one of the two results is consumed degrade into a single
+//  'minimum' or 'maximum'. For N = 3 this yields the classic 4-instruction median of three.
+//
+struct comparator
+{
+    uint8_t     lo;     //- Wire receiving the smaller value
+    uint8_t     hi;     //- Wire receiving the larger value
+    uint8_t     op;     //- Which of the two results is still needed (keep_* below)
+};
+
+enum : uint8_t
+{
+    keep_none = 0,
+    keep_min = 1,
+    keep_max = 2,
+    keep_both = keep_min | keep_max,
+};
+
+template<size_t Capacity>
+struct network
+{
+    comparator  ops[Capacity];
+    size_t      size;
+};
+
+constexpr size_t
+    ceil_pow2(size_t n)
+{
+    size_t  pow2 = 1;
+
+    while (pow2 < n)
+    {
+        pow2 *= 2;
+    }
+    return pow2;
+}
+
+//- Visits the comparators of Batcher's network for 'n' inputs. Starting at 'first_run' (a power
+//  of two) skips the stages that sort runs shorter than that; the remaining stages merge inputs
+//  that already consist of sorted runs of 'first_run' values.
+//
+template<typename Visit>
+constexpr void
+    batcher_pairs(size_t n, Visit&& visit, size_t first_run = 1)
+{
+    size_t const    pow2 = ceil_pow2(n);
+
+    for (size_t p = first_run; p < pow2; p *= 2)
+    {
+        for (size_t k = p; k >= 1; k /= 2)
+        {
+            for (size_t j = k % p; j + k < pow2; j += 2 * k)
+            {
+                for (size_t i = 0; i < k && i + j + k < pow2; ++i)
+                {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < n)
+                    {
+                        visit(i + j, i + j + k);
+                    }
+                }
+            }
+        }
+    }
+}
+
+constexpr size_t
+    batcher_size(size_t n)
+{
+    size_t  count = 0;
+
+    batcher_pairs(n, [&count](size_t, size_t) { ++count; });
+    return count;
+}
+
+//- Walks 'net' backwards from the wires flagged in 'needed' and downgrades every comparator to
+//  the results that are still consumed.
+//
+template<size_t Capacity>
+constexpr void
+    prune(network<Capacity>& net, bool* needed)
+{
+    for (size_t i = net.size; i-- > 0;)
+    {
+        comparator&     c = net.ops[i];
+
+        c.op = (needed[c.lo] ? keep_min : keep_none) | (needed[c.hi] ? keep_max : keep_none);
+        needed[c.lo] = needed[c.hi] = (c.op != keep_none);
+    }
+}
+
+template<size_t Capacity>
+constexpr size_t
+    count_operations(network<Capacity> const& net)
+{
+    size_t  count = 0;
+
+    for (size_t i = 0; i < net.size; ++i)
+    {
+        count += (net.ops[i].op & keep_min) ? 1 : 0;
+        count += (net.ops[i].op & keep_max) ? 1 : 0;
+    }
+    return count;
+}
+
+//- Network that leaves the values of rank 'Ranks...' (0 = smallest) of 'N' inputs on the
+//  wires of the same index.
+//
+template<size_t N, size_t... Ranks>
+struct selection_network
+{
+    static_assert(N >= 1 && N <= 64, "");
+    static_assert(sizeof...(Ranks) > 0 && ((Ranks < N) && ...), "");
+
+    static constexpr size_t inputs = N;
+
+    static constexpr network<batcher_size(N) + 1> build()
+    {
+        network<batcher_size(N) + 1>    net{};
+        bool                            needed[N] = {};
+
+        batcher_pairs(N, [&net](size_t lo, size_t hi)
+        {
+            net.ops[net.size++] = comparator{ (uint8_t)lo, (uint8_t)hi, keep_both };
+        });
+
+        ((needed[Ranks] = true), ...);
+        prune(net, needed);
+        return net;
+    }
+
+    static constexpr auto   net = build();
+
+    //- Number of 'minimum'/'maximum' instructions issued per register of output.
+    //
+    static constexpr size_t operations = count_operations(net);
+};
+
+template<size_t N, size_t... I>
+constexpr auto  make_sorting_network(std::index_sequence<I...>) -> selection_network<N, I...>;
+
+//- Network that fully sorts 'N' inputs.
+//
+template<size_t N>
+using sorting_network = decltype(make_sorting_network<N>(std::make_index_sequence<N>()));
+
+//- Network for the median of a 'C' x 'C' window whose columns are already sorted: input
+//  'c * C + k' is the k-th smallest of column 'c'. The rows of the matrix are sorted next, which
+//  keeps the columns sorted. The element in row 'a' and column 'b' is then no larger than the
+//  '(C - a) * (C - b)' elements below and to the right of it and no smaller than the
+//  '(a + 1) * (b + 1)' elements above and to the left, so most elements are ruled out as the
+//  median without further comparisons; the sorted runs of remaining candidates are merged.
+//  Pruning finally drops every comparator, including those of the row sorts, that the median
+//  does not depend on. The median ends up on wire 'output'.
+//
+template<size_t C>
+struct sorted_columns_median_network
+{
+    static constexpr size_t inputs = C * C;
+    static constexpr size_t median = (inputs - 1) / 2;
+
+    static_assert(C % 2 == 1 && inputs <= 64, "");
+
+    struct result
+    {
+        network<batcher_size(C) * C + batcher_size(4 * inputs) + 1>     net;
+        uint8_t                                                         output;
+    };
+
+    static constexpr result build()
+    {
+        result      res{};
+        uint8_t     run[C][C] = {};             //- Candidates of each row, in ascending order
+        size_t      run_length[C] = {};
+        size_t      longest = 1;
+        size_t      below = 0;                  //- Elements ruled out as too small
+        bool        needed[inputs] = {};
+
+        for (size_t k = 0; k < C; ++k)
+        {
+            batcher_pairs(C, [&res, k](size_t lo, size_t hi)
+            {
+                res.net.ops[res.net.size++] = comparator{ (uint8_t)(lo * C + k), (uint8_t)(hi * C + k), keep_both };
+            });
+        }
+
+        for (size_t a = 0; a < C; ++a)
+        {
+            for (size_t b = 0; b < C; ++b)
+            {
+                if ((C - a) * (C - b) > inputs - median)
+                {
+                    ++below;
+                }
+                else if ((a + 1) * (b + 1) <= median + 1)
+                {
+                    run[a][run_length[a]++] = (uint8_t)(b * C + a);
+                }
+            }
+            longest = (run_length[a] > longest) ? run_length[a] : longest;
+        }
+
+        //- The candidates of every row are sorted, so they only need merging. The runs are padded
+        //  with +inf to a common power of two; the padding is tracked symbolically, so comparators
+        //  against it either vanish or turn into a renaming of the wires.
+        //
+        size_t const    run_wires = ceil_pow2(longest);
+        size_t const    wires = ceil_pow2(C * run_wires);
+        uint8_t         input[4 * inputs] = {};         //- Element travelling on each wire
+        bool            padding[4 * inputs] = {};
+
+        for (size_t w = 0; w < wires; ++w)
+        {
+            size_t const    a = w / run_wires;
+
+            padding[w] = (a >= C) || (w % run_wires >= run_length[a]);
+            input[w] = padding[w] ? 0 : run[a][w % run_wires];
+        }
+
+        batcher_pairs(wires, [&](size_t lo, size_t hi)
+        {
+            if (!padding[lo] && !padding[hi])
+            {
+                res.net.ops[res.net.size++] = comparator{ input[lo], input[hi], keep_both };
+            }
+            else if (padding[lo] && !padding[hi])
+            {
+                input[lo] = input[hi];
+                padding[lo] = false;
+                padding[hi] = true;
+            }
+        }, run_wires);
+
+        res.output = input[median - below];
+        needed[res.output] = true;
+        prune(res.net, needed);
+        return res;
+    }
+
+    static constexpr result     built = build();
+    static constexpr auto       net = built.net;
+    static constexpr size_t     output = built.output;
+
+    static constexpr size_t     operations = count_operations(net);
+};
+
+//- Network for the weighted median of 'sizeof...(Weights)' taps, tap 't' counting 'Weights[t]'
+//  times: the median of the sorting network over the expanded inputs, with wire 'w' fed by tap
+//  'tap[w]'. Copies of a tap are equal until one of them passes through a comparator, so the
+//  values on the wires are tracked symbolically and comparators between two copies of the same
+//  value are dropped before pruning. The median ends up on wire 'output'.
+//
+template<size_t... Weights>
+struct weighted_median_network
+{
+    static constexpr size_t inputs = (Weights + ...);
+    static constexpr size_t output = (inputs - 1) / 2;
+
+    static_assert(inputs % 2 == 1 && inputs <= 64, "the weights must add up to an odd count of at most 64");
+
+    struct result
+    {
+        network<batcher_size(inputs) + 1>   net;
+        uint8_t                             tap[inputs];
+    };
+
+    static constexpr result build()
+    {
+        result          res{};
+        size_t const    weights[] = { Weights... };
+        size_t          value[inputs] = {};     //- Symbolic value on each wire
+        size_t          values = sizeof...(Weights);
+        size_t          wire = 0;
+        bool            needed[inputs] = {};
+
+        for (size_t t = 0; t < sizeof...(Weights); ++t)
+        {
+            for (size_t copy = 0; copy < weights[t]; ++copy, ++wire)
+            {
+                res.tap[wire] = (uint8_t)t;
+                value[wire] = t;
+            }
+        }
+
+        batcher_pairs(inputs, [&](size_t lo, size_t hi)
+        {
+            if (value[lo] != value[hi])
+            {
+                res.net.ops[res.net.size++] = comparator{ (uint8_t)lo, (uint8_t)hi, keep_both };
+                value[lo] = values++;
+                value[hi] = values++;
+            }
+        });
+
+        needed[output] = true;
+        prune(res.net, needed);
+        return res;
+    }
+
+    static constexpr result     built = build();
+    static constexpr auto       net = built.net;
+
+    static constexpr size_t     operations = count_operations(net);
+};
+
+template<typename Network, size_t I, typename R>
+KEWB_FORCE_INLINE void
+    apply_comparator(R* s)
+{
+    constexpr comparator    c = Network::net.ops[I];
+
+    if constexpr (c.op == keep_both)
+    {
+        R const     tmp = minimum(s[c.lo], s[c.hi]);
+
+        s[c.hi] = maximum(s[c.lo], s[c.hi]);
+        s[c.lo] = tmp;
+    }
+    else if constexpr (c.op == keep_min)
+    {
+        s[c.lo] = minimum(s[c.lo], s[c.hi]);
+    }
+    else if constexpr (c.op == keep_max)
+    {
+        s[c.hi] = maximum(s[c.lo], s[c.hi]);
+    }
+}
+
+template<typename Network, typename R, size_t... I>
+KEWB_FORCE_INLINE void
+    apply_network(R* s, std::index_sequence<I...>)
+{
+    (apply_comparator<Network, I>(s), ...);
+}
+
+//- Runs 'Network' over the registers 's[0] .. s[N-1]'; every register is an independent
+//  column of the network, so each lane of the result is a selection over its own inputs.
+//
+template<typename Network, typename R>
+KEWB_FORCE_INLINE void
+    apply_network(R* s)
+{
+    apply_network<Network>(s, std::make_index_sequence<Network::net.size>());
+}
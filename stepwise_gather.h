@@ -0,0 +1,147 @@
+#pragma once
+
+#include "avx-median.h"
+
+//- Gathers every other element, starting at 'Offset', out of the concatenation of three
+//  registers 'lo | med | hi' of 'Lanes' elements each (16 floats or 8 doubles).
+//
+template<int Offset, int Lanes = 16>
+struct StepwiseGather
+{
+    static_assert(Offset < Lanes, "");
+    static_assert(Lanes == 16 || Lanes == 8, "");
+
+    template<int V> static constexpr uint8_t C = V < 0 ? 0 : V > Lanes - 1 ? 0 : (uint8_t)V;
+
+    template<int RegStart>
+    static __m512i stepwise_permute()
+    {
+        if constexpr (Lanes == 8)
+        {
+            return make_permute64<C<Offset - RegStart>, C<Offset + 2 - RegStart>, C<Offset + 4 - RegStart>, C<Offset + 6 - RegStart>,
+                C<Offset + 8 - RegStart>, C<Offset + 10 - RegStart>, C<Offset + 12 - RegStart>, C<Offset + 14 - RegStart>>();
+        }
+        else
+        {
+            return make_permute<C<Offset - RegStart>, C<Offset + 2 - RegStart>, C<Offset + 4 - RegStart>, C<Offset + 6 - RegStart>,
+                C<Offset + 8 - RegStart>, C<Offset + 10 - RegStart>, C<Offset + 12 - RegStart>, C<Offset + 14 - RegStart>,
+                C<Offset + 16 - RegStart>, C<Offset + 18 - RegStart>, C<Offset + 20 - RegStart>, C<Offset + 22 - RegStart>,
+                C<Offset + 24 - RegStart>, C<Offset + 26 - RegStart>, C<Offset + 28 - RegStart>, C<Offset + 30 - RegStart>>();
+        }
+    }
+
+    template<unsigned int RegStart>
+    static constexpr m512 make_loadmask()
+    {
+        static_assert(Offset < RegStart, "");
+        constexpr auto loaded = (RegStart - Offset + 1) / 2;
+        constexpr m512 full = (1ul << Lanes) - 1;
+        if constexpr (loaded >= Lanes)
+            return 0;
+        else
+            return (full << loaded) & full;
+    }
+
+    template<typename R>
+    KEWB_FORCE_INLINE
+    R operator()(R lo, R med, R hi) const noexcept
+    {
+        R data = permute(lo, perm_lo);
+        data = mask_permute(data, med, perm_med, mask_med);
+        if constexpr (mask_hi != 0)
+            data = mask_permute(data, hi, perm_hi, mask_hi);
+        return data;
+    }
+
+    const __m512i perm_lo = stepwise_permute<0>();
+    const __m512i perm_med = stepwise_permute<Lanes>();
+    const __m512i perm_hi = stepwise_permute<2 * Lanes>();
+
+    static constexpr auto mask_med = make_loadmask<Lanes>();
+    static constexpr auto mask_hi = make_loadmask<2 * Lanes>();
+};
+
+//- De-interleaves 16 frames of 'Channels' interleaved samples (e.g. LRLR or RGBRGB), held in
+//  'Channels' consecutive registers, into one register per channel, and interleaves them back.
+//  Sample 'g' of the frames lives in register 'g / 16'; with 'g & 31' as the index, a two-source
+//  permute reads any sample of the first two registers and, for 3 and 4 channels, a second
+//  permute of the last register(s) supplies the samples beyond them.
+//
+template<int Channels>
+struct ChannelGather
+{
+    static_assert(Channels >= 2 && Channels <= 4, "");
+
+    struct tables
+    {
+        int32_t     gather[Channels][16];   //- Per channel, index of the sample of frame 'f'
+        uint32_t    gather_hi[Channels];    //- Lanes read from the register(s) beyond the first two
+        int32_t     scatter[Channels][16];  //- Per register, index of lane 'l' in its channel pair
+        uint32_t    scatter_hi[Channels];   //- Lanes taken from channels 2 and 3
+    };
+
+    static constexpr tables make_tables()
+    {
+        tables  t{};
+
+        for (int c = 0; c < Channels; ++c)
+        {
+            for (int f = 0; f < 16; ++f)
+            {
+                int const   g = Channels * f + c;
+
+                t.gather[c][f] = g & 31;
+                t.gather_hi[c] |= (g >= 32) ? 1u << f : 0u;
+            }
+        }
+        for (int r = 0; r < Channels; ++r)
+        {
+            for (int l = 0; l < 16; ++l)
+            {
+                int const   g = 16 * r + l;
+
+                t.scatter[r][l] = g / Channels + 16 * (g % Channels % 2);
+                t.scatter_hi[r] |= (g % Channels >= 2) ? 1u << l : 0u;
+            }
+        }
+        return t;
+    }
+
+    static constexpr tables     table = make_tables();
+
+    template<int C>
+    KEWB_FORCE_INLINE
+    static rf512 channel(rf512 const* frames)
+    {
+        __m512i const   idx = _mm512_loadu_si512(table.gather[C]);
+        rf512           data = _mm512_permutex2var_ps(frames[0], idx, frames[1]);
+
+        if constexpr (Channels == 3)
+        {
+            data = _mm512_mask_permutexvar_ps(data, (__mmask16)table.gather_hi[C], idx, frames[2]);
+        }
+        else if constexpr (Channels == 4)
+        {
+            data = blend(data, _mm512_permutex2var_ps(frames[2], idx, frames[3]), table.gather_hi[C]);
+        }
+        return data;
+    }
+
+    template<int R>
+    KEWB_FORCE_INLINE
+    static rf512 frame(rf512 const* channels)
+    {
+        __m512i const   idx = _mm512_loadu_si512(table.scatter[R]);
+        rf512           data = _mm512_permutex2var_ps(channels[0], idx, channels[1]);
+
+        if constexpr (Channels == 3)
+        {
+            data = _mm512_mask_permutexvar_ps(data, (__mmask16)table.scatter_hi[R], idx, channels[2]);
+        }
+        else if constexpr (Channels == 4)
+        {
+            data = blend(data, _mm512_permutex2var_ps(channels[2], idx, channels[3]), table.scatter_hi[R]);
+        }
+        return data;
+    }
+};
@@ -0,0 +1,122 @@
+#include "thread_pool.h"
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex>     lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::instance()
+{
+    static ThreadPool   pool;
+    return pool;
+}
+
+void ThreadPool::parallel_for(size_t count, size_t threads, const std::function<void(size_t)>& task)
+{
+    std::lock_guard<std::mutex>     call_lock(m_call_mutex);
+
+    if (threads == 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads > count)
+    {
+        threads = count;
+    }
+    if (threads <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    grow(threads - 1);
+
+    {
+        std::lock_guard<std::mutex>     lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_seats = threads - 1;
+        m_next = 0;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    run_tasks(task);
+
+    std::unique_lock<std::mutex>    lock(m_mutex);
+    m_done.wait(lock, [this] { return m_active == 0; });
+    m_seats = 0;
+    m_task = nullptr;
+}
+
+//- A new worker starts from the generation current when it is created, not when it first gets
+//  to run: a worker scheduled only after parallel_for has published its job would otherwise take
+//  that job as already seen and sleep through it.
+//
+void ThreadPool::grow(size_t workers)
+{
+    size_t  generation;
+
+    {
+        std::lock_guard<std::mutex>     lock(m_mutex);
+        generation = m_generation;
+    }
+
+    while (m_workers.size() < workers)
+    {
+        m_workers.emplace_back([this, generation] { worker_loop(generation); });
+    }
+}
+
+void ThreadPool::worker_loop(size_t seen)
+{
+    std::unique_lock<std::mutex>    lock(m_mutex);
+
+    for (;;)
+    {
+        m_wake.wait(lock, [this, &seen] { return m_stop || m_generation != seen; });
+        if (m_stop)
+        {
+            return;
+        }
+
+        seen = m_generation;
+        if (m_seats == 0)
+        {
+            continue;
+        }
+
+        --m_seats;
+        ++m_active;
+        const std::function<void(size_t)>&  task = *m_task;
+
+        lock.unlock();
+        run_tasks(task);
+        lock.lock();
+
+        if (--m_active == 0)
+        {
+            m_done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::run_tasks(const std::function<void(size_t)>& task)
+{
+    for (size_t i = m_next++; i < m_count; i = m_next++)
+    {
+        task(i);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//- A persistent pool of worker threads. Workers are created on first demand and then stay
+//  parked on a condition variable between calls, so a parallel call costs a wake-up rather
+//  than a thread creation.
+//
+class ThreadPool
+{
+public:
+    ThreadPool() = default;
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    //- Calls 'task(i)' for every i in [0, count) using at most 'threads' threads, the calling
+    //  thread included, and returns once all of them have completed. Indices are handed out
+    //  dynamically, so uneven tasks balance themselves.
+    //
+    void    parallel_for(size_t count, size_t threads, const std::function<void(size_t)>& task);
+
+    //- The process-wide pool shared by the multithreaded kernels.
+    //
+    static ThreadPool&  instance();
+
+private:
+    void    grow(size_t workers);
+    void    worker_loop(size_t seen);
+    void    run_tasks(const std::function<void(size_t)>& task);
+
+    std::mutex                          m_call_mutex;   //- Serialises concurrent callers
+    std::mutex                          m_mutex;
+    std::condition_variable             m_wake;
+    std::condition_variable             m_done;
+    std::vector<std::thread>            m_workers;
+
+    const std::function<void(size_t)>*  m_task = nullptr;
+    size_t                              m_count = 0;
+    size_t                              m_seats = 0;        //- Workers still allowed to join
+    size_t                              m_active = 0;       //- Workers running the current job
+    size_t                              m_generation = 0;
+    bool                                m_stop = false;
+    std::atomic<size_t>                 m_next{ 0 };
+};
@@ -0,0 +1,9 @@
+#include "weighted_median.h"
+
+template void weighted_median<1, 1, 1, 1, 1, 1, 1>(const float*, float*, size_t);
+template void weighted_median<0, 1, 1, 1, 1, 1, 0>(const float*, float*, size_t);
+template void weighted_median<1, 2, 2, 3, 2, 2, 1>(const float*, float*, size_t);
+template void weighted_median<1, 2, 3, 5, 3, 2, 1>(const float*, float*, size_t);
+template void center_weighted_median<1>(const float*, float*, size_t);
+template void center_weighted_median<3>(const float*, float*, size_t);
+template void center_weighted_median<5>(const float*, float*, size_t);
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "avx-median.h"
+#include "output_writer.h"
+#include "selection_network.h"
+
+#include <utility>
+
+//- Definitions of weighted_median and center_weighted_median. weighted_median.cpp instantiates
+//  the weight sets listed in avx-median.h; a translation unit compiled for AVX-512 includes this
+//  header to instantiate any other weights.
+//
+
+//- Weighted median of the 7-tap window for 16 consecutive outputs at once, laid out as in
+//  median_filter: each tap is one register, each wire of the expanded network is a copy of the
+//  register of its tap, and the network runs vertically across them.
+//
+template<int... Weights, size_t... W>
+KEWB_FORCE_INLINE
+rf512 weighted_process16(rf512 const* taps, std::index_sequence<W...>)
+{
+    using median_network = weighted_median_network<(size_t)Weights...>;
+
+    rf512   s[] = { taps[median_network::built.tap[W]]... };
+
+    apply_network<median_network>(s);
+    return s[median_network::output];
+}
+
+template<int... Weights>
+KEWB_FORCE_INLINE
+rf512 weighted_process16(rf512 prev, rf512 curr, rf512 next)
+{
+    using median_network = weighted_median_network<(size_t)Weights...>;
+
+    rf512 const     taps[] =
+    {
+        window_tap<-3>(prev, curr, next),
+        window_tap<-2>(prev, curr, next),
+        window_tap<-1>(prev, curr, next),
+        curr,
+        window_tap<1>(prev, curr, next),
+        window_tap<2>(prev, curr, next),
+        window_tap<3>(prev, curr, next),
+    };
+
+    return weighted_process16<Weights...>(taps, std::make_index_sequence<median_network::inputs>());
+}
+
+template<int... Weights>
+void weighted_median(const float* psrc, float* pdst, size_t buf_len)
+{
+    static_assert(sizeof...(Weights) == 7 && ((Weights >= 0) && ...), "one weight per tap of the window");
+
+    __m512      prev;   //- Bottom of the input data window
+    __m512      curr;   //- Middle of the input data window
+    __m512      next;   //- Top of the input data window
+    __m512      data;   //- Holds output prior to store operation
+
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    CachedWriter    out(pdst);
+    rf512 const     last = load_value(psrc[buf_len - 1]);
+
+    //- The register before the input holds copies of its first element. Each block of output is
+    //  stored after the block above it has been read, so 'pdst' may equal 'psrc'.
+    //
+    prev = load_value(psrc[0]);
+    curr = load_clamped(psrc, 0, buf_len, last);
+
+    for (size_t wrote = 0;; wrote += 16)
+    {
+        next = load_clamped(psrc, wrote + 16, buf_len, last);
+        data = weighted_process16<Weights...>(prev, curr, next);
+
+        if (wrote + 16 < buf_len)
+        {
+            out.put(data);
+        }
+        else
+        {
+            out.put_last(data, buf_len - wrote);
+            return;
+        }
+
+        prev = curr;
+        curr = next;
+    }
+}
+
+template<int CenterWeight>
+void center_weighted_median(const float* psrc, float* pdst, size_t buf_len)
+{
+    weighted_median<1, 1, 1, CenterWeight, 1, 1, 1>(psrc, pdst, buf_len);
+}